@@ -0,0 +1,56 @@
+#pragma once
+
+#include "HugePages.hpp"
+
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+//Arena is a simple bump allocator over one contiguous block.
+// Allocations are never freed individually; the whole block goes away with the arena.
+// Handy for pools of same-lifetime data (e.g., all the boards owned by a server shard),
+// since it keeps that data contiguous and lets the owning thread be the first to touch it.
+//With a HugePages policy other than Off, the block is allocated by HugePages instead of new[]
+// (so it can be backed by 2MB pages; see HugePages.hpp).
+struct Arena {
+	explicit Arena(size_t capacity_, HugePages::Policy policy = HugePages::Off) : capacity(capacity_) {
+		char *start;
+		if (policy == HugePages::Off) {
+			block.reset(new char[capacity + Alignment]);
+			start = block.get();
+		} else {
+			pages.reset(new HugePages::Block(capacity + Alignment, policy));
+			start = reinterpret_cast< char * >(pages->data);
+		}
+		//align the start of the usable space:
+		uintptr_t at = reinterpret_cast< uintptr_t >(start);
+		base = start + ((Alignment - (at % Alignment)) % Alignment);
+	}
+	Arena(Arena const &) = delete;
+	Arena &operator=(Arena const &) = delete;
+
+	//allocate (uninitialized) space for 'count' elements of type T:
+	template< typename T >
+	T *alloc(size_t count, size_t align = alignof(T)) {
+		assert(align <= Alignment && (align & (align - 1)) == 0);
+		size_t at = (used + align - 1) & ~(align - 1);
+		if (at + count * sizeof(T) > capacity) {
+			throw std::bad_alloc();
+		}
+		used = at + count * sizeof(T);
+		return reinterpret_cast< T * >(base + at);
+	}
+
+	//bytes in use (including padding):
+	size_t size() const { return used; }
+
+	enum : size_t { Alignment = 64 }; //cache-line alignment for the block start
+
+	size_t capacity = 0;
+	size_t used = 0;
+	std::unique_ptr< char[] > block; //if allocated with new[]
+	std::unique_ptr< HugePages::Block > pages; //if allocated by HugePages
+	char *base = nullptr;
+};
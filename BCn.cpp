@@ -0,0 +1,389 @@
+#include "BCn.hpp"
+
+#include "Mipmaps.hpp"
+#include "MappedChunks.hpp"
+#include "write_chunk.hpp"
+
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace BCn {
+
+uint32_t block_bytes(Format format) {
+	return (format == BC1 ? 8 : 16);
+}
+
+size_t level_bytes(Format format, glm::uvec2 size) {
+	return size_t((size.x + 3) / 4) * ((size.y + 3) / 4) * block_bytes(format);
+}
+
+//------- color (BC1-style) blocks -------
+
+static uint16_t pack_565(glm::vec3 const &c) {
+	glm::vec3 q = glm::clamp(c, 0.0f, 255.0f);
+	uint32_t r = uint32_t(q.x * (31.0f / 255.0f) + 0.5f);
+	uint32_t g = uint32_t(q.y * (63.0f / 255.0f) + 0.5f);
+	uint32_t b = uint32_t(q.z * (31.0f / 255.0f) + 0.5f);
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static glm::ivec3 unpack_565(uint16_t c) {
+	uint32_t r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+	return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+//the four colors a (four-color mode) block can choose from:
+static void color_palette(uint16_t c0, uint16_t c1, glm::ivec3 palette[4]) {
+	palette[0] = unpack_565(c0);
+	palette[1] = unpack_565(c1);
+	palette[2] = (2 * palette[0] + palette[1]) / 3;
+	palette[3] = (palette[0] + 2 * palette[1]) / 3;
+}
+
+//choose the nearest palette entry for each texel; returns the total squared error:
+static uint32_t color_indices(uint16_t c0, uint16_t c1, glm::ivec3 const texels[16], uint8_t indices[16]) {
+	glm::ivec3 palette[4];
+	color_palette(c0, c1, palette);
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t best = -1U;
+		for (uint8_t k = 0; k < 4; ++k) {
+			glm::ivec3 d = texels[i] - palette[k];
+			uint32_t err = uint32_t(d.x * d.x + d.y * d.y + d.z * d.z);
+			if (err < best) {
+				best = err;
+				indices[i] = k;
+			}
+		}
+		total += best;
+	}
+	return total;
+}
+
+static void encode_color(Quality quality, glm::u8vec4 const texels[16], uint8_t *out) {
+	glm::ivec3 colors[16];
+	glm::vec3 mean(0.0f);
+	glm::vec3 lo(255.0f), hi(0.0f);
+	for (uint32_t i = 0; i < 16; ++i) {
+		colors[i] = glm::ivec3(texels[i].x, texels[i].y, texels[i].z);
+		glm::vec3 c = glm::vec3(colors[i]);
+		mean += c;
+		lo = glm::min(lo, c);
+		hi = glm::max(hi, c);
+	}
+	mean /= 16.0f;
+
+	glm::vec3 e0, e1;
+	if (quality == Fast) {
+		//bounding box diagonal, inset by 1/16 (endpoints at the extremes waste precision on outliers):
+		glm::vec3 inset = (hi - lo) / 16.0f;
+		e0 = hi - inset;
+		e1 = lo + inset;
+	} else {
+		//principal axis of the colors (power iteration on the covariance matrix):
+		glm::mat3 cov(0.0f);
+		for (uint32_t i = 0; i < 16; ++i) {
+			glm::vec3 d = glm::vec3(colors[i]) - mean;
+			for (uint32_t r = 0; r < 3; ++r) {
+				for (uint32_t c = 0; c < 3; ++c) {
+					cov[c][r] += d[r] * d[c];
+				}
+			}
+		}
+		glm::vec3 axis = hi - lo;
+		for (uint32_t iter = 0; iter < 8; ++iter) {
+			glm::vec3 next = cov * axis;
+			float len = glm::length(next);
+			if (!(len > 1e-6f)) break;
+			axis = next / len;
+		}
+		float len = glm::length(axis);
+		if (len > 1e-6f) {
+			axis /= len;
+			float t_min = 0.0f, t_max = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i) {
+				float t = glm::dot(glm::vec3(colors[i]) - mean, axis);
+				t_min = std::min(t_min, t);
+				t_max = std::max(t_max, t);
+			}
+			e0 = mean + t_max * axis;
+			e1 = mean + t_min * axis;
+		} else {
+			e0 = e1 = mean;
+		}
+	}
+
+	uint16_t c0 = pack_565(e0), c1 = pack_565(e1);
+	uint8_t indices[16];
+	uint32_t error = color_indices(c0, c1, colors, indices);
+
+	if (quality == High) {
+		//refine: given the indices, solve for the endpoints that minimize squared error, and keep them if better:
+		static float const weight0[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f}; //weight of endpoint 0 per index
+		for (uint32_t iter = 0; iter < 2 && error > 0; ++iter) {
+			float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			glm::vec3 ax(0.0f), bx(0.0f);
+			for (uint32_t i = 0; i < 16; ++i) {
+				float a = weight0[indices[i]], b = 1.0f - a;
+				aa += a * a;
+				bb += b * b;
+				ab += a * b;
+				ax += a * glm::vec3(colors[i]);
+				bx += b * glm::vec3(colors[i]);
+			}
+			float det = aa * bb - ab * ab;
+			if (!(std::abs(det) > 1e-6f)) break;
+			uint16_t r0 = pack_565((ax * bb - bx * ab) / det);
+			uint16_t r1 = pack_565((bx * aa - ax * ab) / det);
+			uint8_t refined[16];
+			uint32_t refined_error = color_indices(r0, r1, colors, refined);
+			if (refined_error >= error) break;
+			c0 = r0;
+			c1 = r1;
+			error = refined_error;
+			std::copy(refined, refined + 16, indices);
+		}
+	}
+
+	//four-color mode needs c0 > c1; swap endpoints (and indices) if needed:
+	if (c0 < c1) {
+		std::swap(c0, c1);
+		static uint8_t const swapped[4] = {1, 0, 3, 2};
+		for (uint32_t i = 0; i < 16; ++i) indices[i] = swapped[indices[i]];
+	} else if (c0 == c1) {
+		for (uint32_t i = 0; i < 16; ++i) indices[i] = 0;
+	}
+
+	uint32_t bits = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		bits |= uint32_t(indices[i]) << (2 * i);
+	}
+	out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+	out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+	out[4] = uint8_t(bits); out[5] = uint8_t(bits >> 8); out[6] = uint8_t(bits >> 16); out[7] = uint8_t(bits >> 24);
+}
+
+static void decode_color(bool allow_three_color, uint8_t const *in, glm::u8vec4 texels[16]) {
+	uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+	uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+	uint32_t bits = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+
+	glm::u8vec4 palette[4];
+	glm::ivec3 p[4];
+	color_palette(c0, c1, p);
+	if (allow_three_color && c0 <= c1) {
+		//three-color mode: midpoint and transparent black:
+		p[2] = (p[0] + p[1]) / 2;
+		p[3] = glm::ivec3(0);
+	}
+	for (uint32_t k = 0; k < 4; ++k) {
+		palette[k] = glm::u8vec4(p[k].x, p[k].y, p[k].z, 0xff);
+	}
+	if (allow_three_color && c0 <= c1) palette[3].w = 0;
+
+	for (uint32_t i = 0; i < 16; ++i) {
+		texels[i] = palette[(bits >> (2 * i)) & 3];
+	}
+}
+
+//------- alpha (BC3) blocks -------
+
+static void alpha_palette(uint8_t a0, uint8_t a1, int32_t palette[8]) {
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1) {
+		for (int32_t k = 2; k < 8; ++k) palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+	} else {
+		for (int32_t k = 2; k < 6; ++k) palette[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void encode_alpha(glm::u8vec4 const texels[16], uint8_t *out) {
+	uint8_t lo = 255, hi = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		lo = std::min(lo, texels[i].w);
+		hi = std::max(hi, texels[i].w);
+	}
+	//eight-value mode (a0 > a1) spans [lo,hi]; a flat block uses a0 == a1 and all-zero indices:
+	uint8_t a0 = hi, a1 = lo;
+	int32_t palette[8];
+	alpha_palette(a0, a1, palette);
+
+	uint64_t bits = 0;
+	if (a0 != a1) {
+		for (uint32_t i = 0; i < 16; ++i) {
+			uint32_t best = -1U, best_k = 0;
+			for (uint32_t k = 0; k < 8; ++k) {
+				uint32_t err = uint32_t(std::abs(int32_t(texels[i].w) - palette[k]));
+				if (err < best) {
+					best = err;
+					best_k = k;
+				}
+			}
+			bits |= uint64_t(best_k) << (3 * i);
+		}
+	}
+	out[0] = a0;
+	out[1] = a1;
+	for (uint32_t b = 0; b < 6; ++b) {
+		out[2 + b] = uint8_t(bits >> (8 * b));
+	}
+}
+
+static void decode_alpha(uint8_t const *in, glm::u8vec4 texels[16]) {
+	int32_t palette[8];
+	alpha_palette(in[0], in[1], palette);
+	uint64_t bits = 0;
+	for (uint32_t b = 0; b < 6; ++b) {
+		bits |= uint64_t(in[2 + b]) << (8 * b);
+	}
+	for (uint32_t i = 0; i < 16; ++i) {
+		texels[i].w = uint8_t(palette[(bits >> (3 * i)) & 7]);
+	}
+}
+
+//------- blocks and images -------
+
+void encode_block(Format format, Quality quality, glm::u8vec4 const texels[16], uint8_t *out) {
+	if (format == BC1) {
+		encode_color(quality, texels, out);
+	} else {
+		encode_alpha(texels, out);
+		encode_color(quality, texels, out + 8);
+	}
+}
+
+void decode_block(Format format, uint8_t const *in, glm::u8vec4 texels[16]) {
+	if (format == BC1) {
+		decode_color(true, in, texels);
+	} else {
+		decode_color(false, in + 8, texels); //(BC3 color blocks are always four-color)
+		decode_alpha(in, texels);
+	}
+}
+
+void encode(Format format, Quality quality, glm::uvec2 size, glm::u8vec4 const *pixels, uint8_t *out, uint32_t threads) {
+	glm::uvec2 blocks = (size + glm::uvec2(3)) / glm::uvec2(4);
+	uint32_t stride = block_bytes(format);
+
+	auto encode_rows = [&](uint32_t row_begin, uint32_t row_end) {
+		glm::u8vec4 texels[16];
+		for (uint32_t by = row_begin; by < row_end; ++by) {
+			for (uint32_t bx = 0; bx < blocks.x; ++bx) {
+				for (uint32_t i = 0; i < 16; ++i) {
+					uint32_t x = std::min(bx * 4 + (i % 4), size.x - 1);
+					uint32_t y = std::min(by * 4 + (i / 4), size.y - 1);
+					texels[i] = pixels[y * size.x + x];
+				}
+				encode_block(format, quality, texels, out + (size_t(by) * blocks.x + bx) * stride);
+			}
+		}
+	};
+
+	threads = std::max(1U, std::min(threads, blocks.y));
+	std::vector< std::thread > extra;
+	for (uint32_t t = 1; t < threads; ++t) {
+		extra.emplace_back(encode_rows, blocks.y * t / threads, blocks.y * (t + 1) / threads);
+	}
+	encode_rows(0, blocks.y / threads);
+	for (auto &thread : extra) {
+		thread.join();
+	}
+}
+
+void decode(Format format, glm::uvec2 size, uint8_t const *in, std::vector< glm::u8vec4 > *pixels) {
+	glm::uvec2 blocks = (size + glm::uvec2(3)) / glm::uvec2(4);
+	uint32_t stride = block_bytes(format);
+	pixels->resize(size.x * size.y);
+	glm::u8vec4 texels[16];
+	for (uint32_t by = 0; by < blocks.y; ++by) {
+		for (uint32_t bx = 0; bx < blocks.x; ++bx) {
+			decode_block(format, in + (size_t(by) * blocks.x + bx) * stride, texels);
+			for (uint32_t i = 0; i < 16; ++i) {
+				uint32_t x = bx * 4 + (i % 4), y = by * 4 + (i / 4);
+				if (x < size.x && y < size.y) (*pixels)[y * size.x + x] = texels[i];
+			}
+		}
+	}
+}
+
+//------- files -------
+
+void map(MappedChunks const &file, Format *format, glm::uvec2 *size, std::vector< uint8_t const * > *levels) {
+	std::string const &filename = file.path;
+	MappedChunks::Chunk const *header_chunk = file.find("bch0");
+	MappedChunks::Chunk const *data_chunk = file.find("bcn0");
+	if (!header_chunk || !data_chunk) {
+		throw std::runtime_error("'" + filename + "' is missing its header or block data.");
+	}
+	size_t count = 0;
+	Header const *header = MappedChunks::data_as< Header >(*header_chunk, &count);
+	if (count != 1) {
+		throw std::runtime_error("Expecting one header in '" + filename + "'.");
+	}
+	if (header->format != BC1 && header->format != BC3) {
+		throw std::runtime_error("Unknown block format in '" + filename + "'.");
+	}
+	*format = Format(header->format);
+	*size = glm::uvec2(header->width, header->height);
+	if (size->x == 0 || size->y == 0 || header->levels == 0 || header->levels > mipmap_levels(*size)) {
+		throw std::runtime_error("Invalid size or level count in '" + filename + "'.");
+	}
+
+	levels->resize(header->levels);
+	size_t offset = 0;
+	glm::uvec2 level_size = *size;
+	for (auto &level : *levels) {
+		size_t bytes = level_bytes(*format, level_size);
+		if (offset + bytes > data_chunk->size) {
+			throw std::runtime_error("Block data in '" + filename + "' is too short.");
+		}
+		level = data_chunk->data + offset;
+		offset += bytes;
+		level_size = mipmap_size(level_size);
+	}
+	if (offset != data_chunk->size) {
+		throw std::runtime_error("Block data in '" + filename + "' is too long.");
+	}
+}
+
+void load(std::string const &filename, Format *format, glm::uvec2 *size, std::vector< std::vector< uint8_t > > *levels) {
+	MappedChunks file(filename);
+	std::vector< uint8_t const * > mapped;
+	map(file, format, size, &mapped);
+
+	levels->resize(mapped.size());
+	glm::uvec2 level_size = *size;
+	for (size_t l = 0; l < mapped.size(); ++l) {
+		(*levels)[l].assign(mapped[l], mapped[l] + level_bytes(*format, level_size));
+		level_size = mipmap_size(level_size);
+	}
+}
+
+void save(std::string const &filename, Format format, glm::uvec2 size, std::vector< std::vector< uint8_t > > const &levels) {
+	std::vector< Header > header(1);
+	header[0].format = format;
+	header[0].width = size.x;
+	header[0].height = size.y;
+	header[0].levels = uint32_t(levels.size());
+
+	std::vector< uint8_t > data;
+	for (auto const &level : levels) {
+		data.insert(data.end(), level.begin(), level.end());
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+	}
+	write_chunk_file_header(file);
+	write_chunk(file, "bch0", header, ChunkAligned);
+	write_chunk(file, "bcn0", data, ChunkAligned);
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "MappedChunks.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//BCn encodes and decodes S3TC (a.k.a. DXT) block-compressed textures, which GPUs sample
+// directly, so they stay compressed in video memory:
+// - BC1 (DXT1): 8 bytes per 4x4 block -- two RGB565 endpoints, and a 2-bit index per texel
+//   choosing an endpoint or one of two colors between them (1/8 the size of RGBA8; opaque);
+// - BC3 (DXT5): 16 bytes per 4x4 block -- an alpha block (two 8-bit endpoints and a 3-bit
+//   index per texel) followed by a BC1-style color block (1/4 the size of RGBA8).
+//Blocks are stored a row of blocks at a time, in the same row order as the texels they hold
+// (texture data is bottom row first, as OpenGL expects). Images whose sides aren't multiples
+// of 4 are padded by repeating their edge texels.
+//
+//Compressed textures are stored in '.bcn' files (chunk files in the aligned layout, see chunk_header.hpp,
+// so block data can be used straight from a mapped file):
+//  "bch0" chunk: one Header
+//  "bcn0" chunk: uint8_t blocks of every mip level, largest level first
+namespace BCn {
+	enum Format : uint32_t {
+		BC1 = 1,
+		BC3 = 3,
+	};
+
+	enum Quality : uint32_t {
+		Fast = 0, //endpoints from the block's color bounding box (slightly inset)
+		Normal = 1, //endpoints at the extremes of the block's principal color axis
+		High = 2, //as Normal, then least-squares refinement of the endpoints
+	};
+
+	uint32_t block_bytes(Format format);
+	size_t level_bytes(Format format, glm::uvec2 size);
+
+	//one 4x4 block (texels row by row):
+	void encode_block(Format format, Quality quality, glm::u8vec4 const texels[16], uint8_t *out);
+	void decode_block(Format format, uint8_t const *in, glm::u8vec4 texels[16]);
+
+	//a whole image ('out' holds level_bytes(format, size)), rows of blocks split over 'threads' threads:
+	void encode(Format format, Quality quality, glm::uvec2 size, glm::u8vec4 const *pixels, uint8_t *out, uint32_t threads = 1);
+	void decode(Format format, glm::uvec2 size, uint8_t const *in, std::vector< glm::u8vec4 > *pixels);
+
+	struct Header {
+		uint32_t format = 0; //Format
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levels = 0; //mip levels stored (each half the size of the last, down to 1x1 at most)
+	};
+	static_assert(sizeof(Header) == 16, "BCn::Header should be packed.");
+
+	//find the levels of a mapped .bcn file in place (pointers are valid while 'file' lives; throws on failure):
+	void map(MappedChunks const &file, Format *format, glm::uvec2 *size, std::vector< uint8_t const * > *levels);
+
+	//read / write a .bcn file (throw on failure; files are written in the aligned layout, see chunk_header.hpp):
+	void load(std::string const &filename, Format *format, glm::uvec2 *size, std::vector< std::vector< uint8_t > > *levels);
+	void save(std::string const &filename, Format format, glm::uvec2 size, std::vector< std::vector< uint8_t > > const &levels);
+}
@@ -0,0 +1,470 @@
+#include "BoardRenderer.hpp"
+
+#include "gl_errors.hpp" //helper for dumpping OpenGL error messages
+#include "read_chunk.hpp" //helper for reading a vector of structures from a file
+#include "MeshVertices.hpp" //vertex chunks of the meshes file
+#include "data_path.hpp" //helper to get paths relative to executable
+#include "startup_trace.hpp" //helper to time phases of startup
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <cstddef>
+
+//helper defined later; throws if shader compilation fails:
+static GLuint compile_shader(GLenum type, std::string const &source);
+
+BoardRenderer::BoardRenderer() {
+	{ //create an opengl program to perform sun/sky (well, directional+hemispherical) lighting:
+		startup_trace_begin("compile shaders");
+		GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER,
+			"#version 330\n"
+			"uniform mat4 object_to_clip;\n"
+			"uniform mat4x3 object_to_light;\n"
+			"uniform mat3 normal_to_light;\n"
+			"layout(location=0) in vec4 Position;\n" //note: layout keyword used to make sure that the location-0 attribute is always bound to something
+			"in vec3 Normal;\n"
+			"in vec4 Color;\n"
+			"in uint ColorIndex;\n"
+			"uniform sampler1D palette;\n"
+			"in vec2 TexCoord;\n"
+			"out vec3 position;\n"
+			"out vec3 normal;\n"
+			"out vec4 color;\n"
+			"out vec2 texCoord;\n"
+			"void main() {\n"
+			"	gl_Position = object_to_clip * Position;\n"
+			"	position = object_to_light * Position;\n"
+			"	normal = normal_to_light * Normal;\n"
+			"	color = Color * texelFetch(palette, int(ColorIndex), 0);\n"
+			"	texCoord = TexCoord;\n"
+			"}\n"
+		);
+
+		GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER,
+			"#version 330\n"
+			"uniform vec3 sun_direction;\n"
+			"uniform vec3 sun_color;\n"
+			"uniform vec3 sky_direction;\n"
+			"uniform vec3 sky_color;\n"
+			"uniform sampler2D tex;\n"
+			"in vec3 position;\n"
+			"in vec3 normal;\n"
+			"in vec4 color;\n"
+			"in vec2 texCoord;\n"
+			"out vec4 fragColor;\n"
+			"void main() {\n"
+			"	vec3 total_light = vec3(0.0, 0.0, 0.0);\n"
+			"	vec3 n = normalize(normal);\n"
+			"	{ //sky (hemisphere) light:\n"
+			"		vec3 l = sky_direction;\n"
+			"		float nl = 0.5 + 0.5 * dot(n,l);\n"
+			"		total_light += nl * sky_color;\n"
+			"	}\n"
+			"	{ //sun (directional) light:\n"
+			"		vec3 l = sun_direction;\n"
+			"		float nl = max(0.0, dot(n,l));\n"
+			"		total_light += nl * sun_color;\n"
+			"	}\n"
+			"	vec4 albedo = color * texture(tex, texCoord);\n"
+			"	fragColor = vec4(albedo.rgb * total_light, albedo.a);\n"
+			"}\n"
+		);
+		startup_trace_end();
+
+		StartupPhase phase("link program");
+
+		simple_shading.program = glCreateProgram();
+		glAttachShader(simple_shading.program, vertex_shader);
+		glAttachShader(simple_shading.program, fragment_shader);
+		//shaders are reference counted so this makes sure they are freed after program is deleted:
+		glDeleteShader(vertex_shader);
+		glDeleteShader(fragment_shader);
+
+		//link the shader program and throw errors if linking fails:
+		glLinkProgram(simple_shading.program);
+		GLint link_status = GL_FALSE;
+		glGetProgramiv(simple_shading.program, GL_LINK_STATUS, &link_status);
+		if (link_status != GL_TRUE) {
+			std::cerr << "Failed to link shader program." << std::endl;
+			GLint info_log_length = 0;
+			glGetProgramiv(simple_shading.program, GL_INFO_LOG_LENGTH, &info_log_length);
+			std::vector< GLchar > info_log(info_log_length, 0);
+			GLsizei length = 0;
+			glGetProgramInfoLog(simple_shading.program, GLsizei(info_log.size()), &length, &info_log[0]);
+			std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
+			throw std::runtime_error("failed to link program");
+		}
+	}
+
+	{ //read back uniform and attribute locations from the shader program:
+		StartupPhase phase("uniform/attribute lookup");
+		simple_shading.object_to_clip_mat4 = glGetUniformLocation(simple_shading.program, "object_to_clip");
+		simple_shading.object_to_light_mat4x3 = glGetUniformLocation(simple_shading.program, "object_to_light");
+		simple_shading.normal_to_light_mat3 = glGetUniformLocation(simple_shading.program, "normal_to_light");
+
+		simple_shading.sun_direction_vec3 = glGetUniformLocation(simple_shading.program, "sun_direction");
+		simple_shading.sun_color_vec3 = glGetUniformLocation(simple_shading.program, "sun_color");
+		simple_shading.sky_direction_vec3 = glGetUniformLocation(simple_shading.program, "sky_direction");
+		simple_shading.sky_color_vec3 = glGetUniformLocation(simple_shading.program, "sky_color");
+		simple_shading.tex_sampler2D = glGetUniformLocation(simple_shading.program, "tex");
+		simple_shading.palette_sampler1D = glGetUniformLocation(simple_shading.program, "palette");
+
+		simple_shading.Position_vec4 = glGetAttribLocation(simple_shading.program, "Position");
+		simple_shading.Normal_vec3 = glGetAttribLocation(simple_shading.program, "Normal");
+		simple_shading.Color_vec4 = glGetAttribLocation(simple_shading.program, "Color");
+		simple_shading.ColorIndex_uint = glGetAttribLocation(simple_shading.program, "ColorIndex");
+		simple_shading.TexCoord_vec2 = glGetAttribLocation(simple_shading.program, "TexCoord");
+	}
+
+	//vertex attributes and their data are described by the meshes file itself (see MeshVertices.hpp):
+	MeshVertices vertices;
+
+	{ //load mesh data from a binary blob:
+		startup_trace_begin("read meshes.blob");
+		std::ifstream blob(data_path("meshes.blob"), std::ios::binary);
+		//The blob will be made up of three chunks:
+		// the first chunk(s) will be vertex data (a schema naming each attribute's type and layout, then
+		//  the chunks it describes -- or, in older blobs, interleaved position/normal/color; see MeshVertices.hpp)
+		// the second chunk will be characters
+		// the third chunk will be an index, mapping a name (range of characters) to a mesh (range of vertex data)
+		//Blobs exported with texture coordinates have two (or, after 'atlas', three) more:
+		// the fourth chunk will be a texture coordinate for every vertex
+		// the fifth chunk will be, for every index entry, the file name (range of characters) of its texture
+
+		//read vertex data:
+		vertices.read(blob);
+		size_t vertex_count = vertices.size();
+
+		//read character data (for names):
+		std::vector< char > names;
+		read_chunk(blob, "str0", &names);
+
+		//read index:
+		struct IndexEntry {
+			uint32_t name_begin;
+			uint32_t name_end;
+			uint32_t vertex_begin;
+			uint32_t vertex_end;
+		};
+		static_assert(sizeof(IndexEntry) == 16, "IndexEntry should be packed.");
+
+		std::vector< IndexEntry > index_entries;
+		read_chunk(blob, "idx0", &index_entries);
+
+		//read texture coordinates and texture names, if present:
+		std::vector< glm::vec2 > texcoords;
+		struct TextureEntry {
+			uint32_t name_begin; //name_begin == name_end for untextured meshes
+			uint32_t name_end;
+		};
+		static_assert(sizeof(TextureEntry) == 8, "TextureEntry should be packed.");
+		std::vector< TextureEntry > texture_entries;
+		if (blob.peek() != EOF) {
+			read_chunk(blob, "tex0", &texcoords);
+			read_chunk(blob, "txr0", &texture_entries);
+			if (texcoords.size() != vertex_count || texture_entries.size() != index_entries.size()) {
+				throw std::runtime_error("texture chunks do not match vertex and index chunks.");
+			}
+		}
+		//blobs whose textures were packed into atlases (see atlas.cpp) have a sixth chunk
+		// with each mesh's rectangle in its atlas; texture coordinates already point into the
+		// atlas, so drawing doesn't need it:
+		if (!texture_entries.empty() && blob.peek() != EOF) {
+			struct AtlasEntry {
+				uint32_t x, y, width, height;
+			};
+			static_assert(sizeof(AtlasEntry) == 16, "AtlasEntry should be packed.");
+			std::vector< AtlasEntry > atlas_entries;
+			read_chunk(blob, "atl0", &atlas_entries);
+			if (atlas_entries.size() != index_entries.size()) {
+				throw std::runtime_error("atlas chunk does not match index chunk.");
+			}
+		}
+
+		if (blob.peek() != EOF) {
+			std::cerr << "WARNING: trailing data in meshes file." << std::endl;
+		}
+		startup_trace_end();
+
+		//upload vertex data to the graphics card:
+		startup_trace_begin("upload vbo");
+		vertex_vbos.assign(vertices.streams.size(), 0);
+		glGenBuffers(GLsizei(vertex_vbos.size()), vertex_vbos.data());
+		for (uint32_t i = 0; i < vertex_vbos.size(); ++i) {
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_vbos[i]);
+			glBufferData(GL_ARRAY_BUFFER, vertices.streams[i].data.size(), vertices.streams[i].data.data(), GL_STATIC_DRAW);
+			std::vector< uint8_t >().swap(vertices.streams[i].data); //(only the layout is needed from here on)
+		}
+		//(untextured blobs get all-zero texture coordinates, which sample the white placeholder texture)
+		texcoords.resize(vertex_count, glm::vec2(0.0f));
+		glGenBuffers(1, &texcoords_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, texcoords_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * texcoords.size(), texcoords.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		//palette colors are looked up by index in the vertex shader (unpaletted blobs use a one-color white palette):
+		std::vector< glm::u8vec4 > palette = vertices.palette;
+		if (palette.empty()) palette.emplace_back(0xff);
+		glGenTextures(1, &palette_tex);
+		glBindTexture(GL_TEXTURE_1D, palette_tex);
+		glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, GLsizei(palette.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, palette.data());
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_1D, 0);
+		startup_trace_end();
+
+		//start loading textures (they stream in over the first few frames; see TextureLoader.hpp):
+		startup_trace_begin("start texture loads");
+		white_tex = textures.white();
+		std::map< std::string, GLuint > texture_by_name;
+		std::vector< GLuint > entry_textures(index_entries.size(), white_tex);
+		for (uint32_t i = 0; i < texture_entries.size(); ++i) {
+			TextureEntry const &e = texture_entries[i];
+			if (e.name_begin > e.name_end || e.name_end > names.size()) {
+				throw std::runtime_error("invalid name indices in texture entry.");
+			}
+			if (e.name_begin == e.name_end) continue;
+			std::string name(names.begin() + e.name_begin, names.begin() + e.name_end);
+			auto f = texture_by_name.find(name);
+			if (f == texture_by_name.end()) {
+				f = texture_by_name.insert(std::make_pair(name, textures.load(data_path(name)))).first;
+			}
+			entry_textures[i] = f->second;
+		}
+		startup_trace_end();
+
+		//create map to store index entries:
+		StartupPhase phase("build index");
+		std::map< std::string, Mesh > index;
+		for (uint32_t i = 0; i < index_entries.size(); ++i) {
+			IndexEntry const &e = index_entries[i];
+			if (e.name_begin > e.name_end || e.name_end > names.size()) {
+				throw std::runtime_error("invalid name indices in index.");
+			}
+			if (e.vertex_begin > e.vertex_end || e.vertex_end > vertex_count) {
+				throw std::runtime_error("invalid vertex indices in index.");
+			}
+			Mesh mesh;
+			mesh.first = e.vertex_begin;
+			mesh.count = e.vertex_end - e.vertex_begin;
+			mesh.texture = entry_textures[i];
+			auto ret = index.insert(std::make_pair(
+				std::string(names.begin() + e.name_begin, names.begin() + e.name_end),
+				mesh));
+			if (!ret.second) {
+				throw std::runtime_error("duplicate name in index.");
+			}
+		}
+
+		//look up into index map to extract meshes:
+		auto lookup = [&index](std::string const &name) -> Mesh {
+			auto f = index.find(name);
+			if (f == index.end()) {
+				throw std::runtime_error("Mesh named '" + name + "' does not appear in index.");
+			}
+			return f->second;
+		};
+		tile_mesh = lookup("Tile");
+		cursor_mesh = lookup("Cursor");
+		board_meshes[BoardSim::Doll] = lookup("Doll");
+		board_meshes[BoardSim::Egg] = lookup("Egg");
+		board_meshes[BoardSim::Cube] = lookup("Cube");
+	}
+
+	{ //create vertex array object to hold the map from the mesh vertex buffer to shader program attributes:
+		StartupPhase phase("vao setup");
+		glGenVertexArrays(1, &meshes_for_simple_shading_vao);
+		glBindVertexArray(meshes_for_simple_shading_vao);
+		//every attribute in the file that the shader reads is pointed at its buffer, as the file describes it
+		// (e.g., a 3-vector for a 4-vector attribute, or normalized bytes for a float vector, are both okay to do):
+		for (MeshVertices::Attribute const &attribute : vertices.attributes) {
+			GLint location = glGetAttribLocation(simple_shading.program, attribute.name.c_str());
+			if (location == -1) continue; //(extra attributes the shader doesn't use are fine)
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_vbos[attribute.stream]);
+			GLsizei stride = GLsizei(vertices.streams[attribute.stream].stride);
+			if (attribute.integer) {
+				glVertexAttribIPointer(location, attribute.count, attribute.type, stride, (GLbyte *)0 + attribute.offset);
+			} else {
+				glVertexAttribPointer(location, attribute.count, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, stride, (GLbyte *)0 + attribute.offset);
+			}
+			glEnableVertexAttribArray(location);
+			if (GLuint(location) == simple_shading.Normal_vec3) has_Normal = true;
+			if (GLuint(location) == simple_shading.Color_vec4) has_Color = true;
+			if (GLuint(location) == simple_shading.ColorIndex_uint) has_ColorIndex = true;
+		}
+		if (simple_shading.TexCoord_vec2 != -1U) {
+			glBindBuffer(GL_ARRAY_BUFFER, texcoords_vbo);
+			glVertexAttribPointer(simple_shading.TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLbyte *)0);
+			glEnableVertexAttribArray(simple_shading.TexCoord_vec2);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	GL_ERRORS();
+}
+
+BoardRenderer::~BoardRenderer() {
+	glDeleteVertexArrays(1, &meshes_for_simple_shading_vao);
+	meshes_for_simple_shading_vao = -1U;
+
+	glDeleteBuffers(GLsizei(vertex_vbos.size()), vertex_vbos.data());
+	vertex_vbos.clear();
+
+	glDeleteBuffers(1, &texcoords_vbo);
+	texcoords_vbo = -1U;
+
+	glDeleteTextures(1, &palette_tex);
+	palette_tex = 0;
+
+	glDeleteProgram(simple_shading.program);
+	simple_shading.program = -1U;
+
+	GL_ERRORS();
+}
+
+void BoardRenderer::draw(BoardSim const &sim, glm::uvec2 drawable_size) {
+	//stream in any textures that finished decoding:
+	textures.update();
+
+	//Set up a transformation matrix to fit the board in the window:
+	glm::mat4 world_to_clip;
+	{
+		float aspect = float(drawable_size.x) / float(drawable_size.y);
+
+		//want scale such that board * scale fits in [-aspect,aspect]x[-1.0,1.0] screen box:
+		float scale = glm::min(
+			2.0f * aspect / float(sim.board_size.x),
+			2.0f / float(sim.board_size.y)
+		);
+
+		//center of board will be placed at center of screen:
+		glm::vec2 center = 0.5f * glm::vec2(sim.board_size);
+
+		//NOTE: glm matrices are specified in column-major order
+		world_to_clip = glm::mat4(
+			scale / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, scale, 0.0f, 0.0f,
+			0.0f, 0.0f,-1.0f, 0.0f,
+			-(scale / aspect) * center.x, -scale * center.y, 0.0f, 1.0f
+		);
+	}
+
+	//set up graphics pipeline to use data from the meshes and the simple shading program:
+	glBindVertexArray(meshes_for_simple_shading_vao);
+	glUseProgram(simple_shading.program);
+
+	glUniform3fv(simple_shading.sun_color_vec3, 1, glm::value_ptr(glm::vec3(0.81f, 0.81f, 0.76f)));
+	glUniform3fv(simple_shading.sun_direction_vec3, 1, glm::value_ptr(glm::normalize(glm::vec3(-0.2f, 0.2f, 1.0f))));
+	glUniform3fv(simple_shading.sky_color_vec3, 1, glm::value_ptr(glm::vec3(0.2f, 0.2f, 0.3f)));
+	glUniform3fv(simple_shading.sky_direction_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 1.0f, 0.0f)));
+
+	//constant values for shader inputs the meshes file has no attribute for (see "vao setup"):
+	if (simple_shading.Normal_vec3 != -1U && !has_Normal) {
+		glVertexAttrib3f(simple_shading.Normal_vec3, 0.0f, 0.0f, 1.0f);
+	}
+	if (simple_shading.Color_vec4 != -1U && !has_Color) {
+		glVertexAttrib4f(simple_shading.Color_vec4, 1.0f, 1.0f, 1.0f, 1.0f);
+	}
+	if (simple_shading.ColorIndex_uint != -1U && !has_ColorIndex) {
+		glVertexAttribI4ui(simple_shading.ColorIndex_uint, 0, 0, 0, 0);
+	}
+	glUniform1i(simple_shading.palette_sampler1D, 1);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_1D, palette_tex);
+
+	glUniform1i(simple_shading.tex_sampler2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	GLuint bound_tex = 0; //(only rebind when the texture changes; most meshes share the white one)
+
+	//helper function to draw a given mesh with a given transformation:
+	auto draw_mesh = [&](Mesh const &mesh, glm::mat4 const &object_to_world) {
+		//set up the matrix uniforms:
+		if (simple_shading.object_to_clip_mat4 != -1U) {
+			glm::mat4 object_to_clip = world_to_clip * object_to_world;
+			glUniformMatrix4fv(simple_shading.object_to_clip_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+		}
+		if (simple_shading.object_to_light_mat4x3 != -1U) {
+			glUniformMatrix4x3fv(simple_shading.object_to_light_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_world));
+		}
+		if (simple_shading.normal_to_light_mat3 != -1U) {
+			//NOTE: if there isn't any non-uniform scaling in the object_to_world matrix, then the inverse transpose is the matrix itself, and computing it wastes some CPU time:
+			glm::mat3 normal_to_world = glm::inverse(glm::transpose(glm::mat3(object_to_world)));
+			glUniformMatrix3fv(simple_shading.normal_to_light_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_world));
+		}
+
+		if (mesh.texture != bound_tex) {
+			glBindTexture(GL_TEXTURE_2D, mesh.texture);
+			bound_tex = mesh.texture;
+		}
+
+		//draw the mesh:
+		glDrawArrays(GL_TRIANGLES, mesh.first, mesh.count);
+	};
+
+	//(for_each_rotation works for both dense and sparse rotation storage):
+	sim.for_each_rotation([&](uint32_t x, uint32_t y, glm::quat const &rotation){
+		draw_mesh(tile_mesh,
+			glm::mat4(
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				x+0.5f, y+0.5f,-0.5f, 1.0f
+			)
+		);
+		draw_mesh(board_meshes[sim.board_meshes[y*sim.board_size.x+x]],
+			glm::mat4(
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				x+0.5f, y+0.5f, 0.0f, 1.0f
+			)
+			* glm::mat4_cast(rotation)
+		);
+	});
+	draw_mesh(cursor_mesh,
+		glm::mat4(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			sim.cursor.x+0.5f, sim.cursor.y+0.5f, 0.0f, 1.0f
+		)
+	);
+
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_1D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
+
+
+
+//create and return an OpenGL vertex shader from source:
+static GLuint compile_shader(GLenum type, std::string const &source) {
+	GLuint shader = glCreateShader(type);
+	GLchar const *str = source.c_str();
+	GLint length = GLint(source.size());
+	glShaderSource(shader, 1, &str, &length);
+	glCompileShader(shader);
+	GLint compile_status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+	if (compile_status != GL_TRUE) {
+		std::cerr << "Failed to compile shader." << std::endl;
+		GLint info_log_length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::vector< GLchar > info_log(info_log_length, 0);
+		GLsizei length = 0;
+		glGetShaderInfoLog(shader, GLsizei(info_log.size()), &length, &info_log[0]);
+		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
+		glDeleteShader(shader);
+		throw std::runtime_error("Failed to compile shader.");
+	}
+	return shader;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "GL.hpp"
+#include "BoardSim.hpp"
+#include "TextureLoader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// The 'BoardRenderer' struct owns the OpenGL resources (shader program,
+// mesh buffer, vertex array object) used to draw a BoardSim.
+
+struct BoardRenderer {
+	//BoardRenderer creates OpenGL resources (i.e. vertex buffer objects) in its
+	//constructor and frees them in its destructor.
+	BoardRenderer();
+	~BoardRenderer();
+
+	//draw the given board to the current framebuffer:
+	void draw(BoardSim const &sim, glm::uvec2 drawable_size);
+
+	//------- opengl resources -------
+
+	//shader program that draws lit objects with vertex colors:
+	struct {
+		GLuint program = -1U; //program object
+
+		//uniform locations:
+		GLuint object_to_clip_mat4 = -1U;
+		GLuint object_to_light_mat4x3 = -1U;
+		GLuint normal_to_light_mat3 = -1U;
+		GLuint sun_direction_vec3 = -1U;
+		GLuint sun_color_vec3 = -1U;
+		GLuint sky_direction_vec3 = -1U;
+		GLuint sky_color_vec3 = -1U;
+		GLuint tex_sampler2D = -1U;
+		GLuint palette_sampler1D = -1U;
+
+		//attribute locations:
+		GLuint Position_vec4 = -1U;
+		GLuint Normal_vec3 = -1U;
+		GLuint Color_vec4 = -1U;
+		GLuint ColorIndex_uint = -1U;
+		GLuint TexCoord_vec2 = -1U;
+	} simple_shading;
+
+	//mesh data, stored in vertex buffers:
+	std::vector< GLuint > vertex_vbos; //one per vertex data chunk in the meshes file (laid out as its schema says)
+	GLuint texcoords_vbo = -1U; //vertex buffer holding a texture coordinate per mesh vertex
+	GLuint palette_tex = 0; //1D texture of palette colors (a single white texel if the file has no palette)
+
+	//shader inputs the meshes file has no attribute for read constants instead (set in draw()):
+	bool has_Normal = false; //else (0,0,1)
+	bool has_Color = false; //else white
+	bool has_ColorIndex = false; //else 0
+
+	//textures named in the meshes file (loaded and uploaded in the background):
+	TextureLoader textures;
+	GLuint white_tex = 0; //used by untextured meshes
+
+	//The location of each mesh in the meshes vertex buffer:
+	struct Mesh {
+		GLint first = 0;
+		GLsizei count = 0;
+		GLuint texture = 0;
+	};
+
+	Mesh tile_mesh;
+	Mesh cursor_mesh;
+	Mesh board_meshes[BoardSim::MeshIdCount]; //indexed by BoardSim::MeshId
+
+	GLuint meshes_for_simple_shading_vao = -1U; //vertex array object that describes how to connect the vertex_vbos to the simple_shading_program
+};
@@ -0,0 +1,423 @@
+#include "BoardSim.hpp"
+
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+void BoardSim::reset(glm::uvec2 board_size_, uint32_t seed_, bool discrete_, bool sparse_) {
+	if (discrete_ && sparse_) {
+		throw std::runtime_error("Sparse rotations are only supported for continuous boards.");
+	}
+	board_size = board_size_;
+	seed = seed_;
+	discrete = discrete_;
+	sparse = sparse_;
+	cursor = glm::uvec2(0,0);
+	rolling.roll = CubeRotations::NoRoll;
+	tweens.clear();
+
+	//set up game board with meshes and rolls:
+	board_meshes.clear();
+	board_rotations.clear();
+	board_meshes.reserve(board_size.x * board_size.y);
+	std::mt19937 mt(seed);
+
+	for (uint32_t i = 0; i < board_size.x * board_size.y; ++i) {
+		board_meshes.emplace_back(MeshId(mt() % MeshIdCount));
+	}
+
+	if (sparse) {
+		board_rotations.shrink_to_fit();
+		sparse_rotations.reset(board_size);
+		QuantizedRotation const identity = quantize_rotation(glm::quat());
+		identity_hash = 0;
+		for (uint32_t i = 0; i < board_size.x * board_size.y; ++i) {
+			identity_hash ^= cell_hash(i, board_meshes[i], identity);
+		}
+	} else {
+		board_rotations.assign(board_size.x * board_size.y, glm::quat());
+		sparse_rotations.reset(glm::uvec2(0,0));
+	}
+
+	board_orientations.clear();
+	if (discrete) {
+		board_orientations.assign(board_size.x * board_size.y, CubeRotations::Identity);
+	}
+
+	state_hash = compute_hash();
+
+	goal_orientations.clear();
+	goal_matched.clear();
+	goal_matching = 0;
+}
+
+void BoardSim::set_orientations(std::vector< uint8_t > const &orientations) {
+	if (!discrete || orientations.size() != board_orientations.size()) {
+		throw std::runtime_error("set_orientations needs a discrete board of matching size.");
+	}
+	board_orientations = orientations;
+	for (uint32_t i = 0; i < board_orientations.size(); ++i) {
+		board_rotations[i] = CubeRotations::to_quat(board_orientations[i]);
+	}
+	rolling.roll = CubeRotations::NoRoll;
+	tweens.clear();
+	state_hash = compute_hash();
+	for (uint32_t i = 0; i < goal_orientations.size(); ++i) {
+		update_goal(i);
+	}
+}
+
+void BoardSim::set_rotations(std::vector< glm::quat > const &rotations) {
+	if (discrete || rotations.size() != board_size.x * board_size.y) {
+		throw std::runtime_error("set_rotations needs a continuous board of matching size.");
+	}
+	if (sparse) {
+		//only store cells that aren't identity:
+		sparse_rotations.reset(board_size);
+		for (uint32_t i = 0; i < rotations.size(); ++i) {
+			if (rotations[i] != glm::quat()) sparse_rotations.at(i % board_size.x, i / board_size.x) = rotations[i];
+		}
+	} else {
+		board_rotations = rotations;
+	}
+	state_hash = compute_hash();
+	for (uint32_t i = 0; i < goal_orientations.size(); ++i) {
+		update_goal(i);
+	}
+}
+
+void BoardSim::set_rotations(SparseRotations const &rotations) {
+	if (!sparse || rotations.size != board_size) {
+		throw std::runtime_error("set_rotations needs a sparse board of matching size.");
+	}
+	sparse_rotations = rotations;
+	state_hash = compute_hash();
+	for (uint32_t i = 0; i < goal_orientations.size(); ++i) {
+		update_goal(i);
+	}
+}
+
+void BoardSim::set_goal(std::vector< uint8_t > const &orientations) {
+	if (!orientations.empty() && orientations.size() != board_size.x * board_size.y) {
+		throw std::runtime_error("Goal does not match board size.");
+	}
+	goal_orientations = orientations;
+	goal_matched.assign(goal_orientations.size(), 0);
+	goal_matching = 0;
+	for (uint32_t i = 0; i < goal_orientations.size(); ++i) {
+		update_goal(i);
+	}
+}
+
+bool BoardSim::matches_goal(uint32_t i) const {
+	uint8_t goal = goal_orientations[i];
+	if (goal == AnyOrientation) return true;
+	if (discrete) return board_orientations[i] == goal;
+	//q and -q are the same rotation, hence the abs:
+	float d = std::abs(glm::dot(rotation(i % board_size.x, i / board_size.x), CubeRotations::to_quat(goal)));
+	return d >= std::cos(0.5f * goal_tolerance);
+}
+
+void BoardSim::update_goal(uint32_t i) {
+	uint8_t matched = (matches_goal(i) ? 1 : 0);
+	goal_matching = goal_matching - goal_matched[i] + matched;
+	goal_matched[i] = matched;
+}
+
+uint64_t BoardSim::compute_hash() const {
+	uint64_t hash = 0;
+	if (discrete) {
+		//in discrete mode, the hash covers settled orientations (not the animation of an in-flight roll):
+		for (uint32_t i = 0; i < board_size.x * board_size.y; ++i) {
+			hash ^= cell_hash(i, board_meshes[i], quantize_orientation(board_orientations[i]));
+		}
+	} else if (sparse) {
+		//start from the all-identity board, then swap in the cells of allocated chunks that aren't identity:
+		QuantizedRotation const identity = quantize_rotation(glm::quat());
+		hash = identity_hash;
+		sparse_rotations.for_each_chunk([&](glm::uvec2 origin, glm::quat const *cells){
+			glm::uvec2 end = glm::min(origin + glm::uvec2(SparseRotations::ChunkSize), board_size);
+			for (uint32_t y = origin.y; y < end.y; ++y) {
+				for (uint32_t x = origin.x; x < end.x; ++x) {
+					glm::quat const &r = cells[(y - origin.y) * SparseRotations::ChunkSize + (x - origin.x)];
+					if (r == glm::quat()) continue;
+					uint32_t i = y * board_size.x + x;
+					hash ^= cell_hash(i, board_meshes[i], identity) ^ cell_hash(i, board_meshes[i], quantize_rotation(r));
+				}
+			}
+		});
+	} else {
+		for (uint32_t i = 0; i < board_size.x * board_size.y; ++i) {
+			hash ^= cell_hash(i, board_meshes[i], quantize_rotation(board_rotations[i]));
+		}
+	}
+	return hash;
+}
+
+//call fn(index) for each cell on the same row or column as 'cursor' (each cell once):
+template< typename F >
+static inline void for_cross(glm::uvec2 board_size, glm::uvec2 cursor, F const &fn) {
+	for (uint32_t x = 0; x < board_size.x; ++x) {
+		fn(cursor.y * board_size.x + x);
+	}
+	for (uint32_t y = 0; y < board_size.y; ++y) {
+		if (y != cursor.y) fn(y * board_size.x + cursor.x);
+	}
+}
+
+void BoardSim::update(float elapsed, RollAction *performed) {
+	if (performed) *performed = RollAction();
+
+	if (discrete) {
+		//start a quarter turn if a roll key is held and no roll is in flight:
+		if (rolling.roll == CubeRotations::NoRoll) {
+			rolling.roll = CubeRotations::roll_from_bits(controls_to_bits(controls));
+			if (rolling.roll == CubeRotations::NoRoll) return;
+			rolling.cursor = cursor;
+			rolling.t = 0.0f;
+			//animate the cross from its settled orientations to the rolled ones:
+			uint8_t const *table = CubeRotations::tables.roll[rolling.roll];
+			for_cross(board_size, rolling.cursor, [&](uint32_t i){
+				uint8_t o = board_orientations[i];
+				tweens.add(i, CubeRotations::to_quat(o), CubeRotations::to_quat(table[o]), roll_duration);
+			});
+		}
+
+		rolling.t += elapsed / roll_duration;
+		if (rolling.t < 1.0f) {
+			//animation only (board state changes when the turn completes):
+			tweens.update(elapsed, board_rotations.data());
+		} else {
+			//turn complete; update the actual state:
+			RollAction action;
+			action.cursor_x = rolling.cursor.x;
+			action.cursor_y = rolling.cursor.y;
+			action.roll = rolling.roll;
+			apply_action(action);
+			if (performed) *performed = action;
+		}
+		return;
+	}
+
+	//if the roll keys are pressed, rotate everything on the same row or column as the cursor:
+	if (roll_rotation(controls, elapsed) != glm::quat()) {
+		RollAction action;
+		action.cursor_x = cursor.x;
+		action.cursor_y = cursor.y;
+		action.controls = uint8_t(controls_to_bits(controls));
+		action.angle = elapsed;
+		apply_action(action);
+		if (performed) *performed = action;
+	}
+}
+
+void BoardSim::apply_action(RollAction const &action) {
+	glm::uvec2 at(action.cursor_x, action.cursor_y);
+	if (discrete) {
+		if (action.roll == CubeRotations::NoRoll) return;
+		rolling.roll = CubeRotations::NoRoll;
+		tweens.clear(); //rotations of the rolled cross are set below
+		roll_cross_discrete(board_orientations.data(), board_size, at, action.roll, board_meshes.data(), &state_hash);
+		for_cross(board_size, at, [&](uint32_t i){
+			board_rotations[i] = CubeRotations::to_quat(board_orientations[i]);
+			if (!goal_orientations.empty()) update_goal(i);
+		});
+	} else {
+		if (action.controls == 0) return;
+		glm::quat dr = roll_rotation(controls_from_bits(action.controls), action.angle);
+		if (sparse) {
+			//same as roll_cross, but through sparse_rotations (allocating the chunks the cross passes through):
+			for_cross(board_size, at, [&](uint32_t i){
+				glm::quat &r = sparse_rotations.at(i % board_size.x, i / board_size.x);
+				state_hash ^= cell_hash(i, board_meshes[i], quantize_rotation(r));
+				r = glm::normalize(dr * r);
+				state_hash ^= cell_hash(i, board_meshes[i], quantize_rotation(r));
+			});
+		} else {
+			roll_cross(board_rotations.data(), board_size, at, dr, board_meshes.data(), &state_hash);
+		}
+		if (!goal_orientations.empty()) {
+			for_cross(board_size, at, [&](uint32_t i){ update_goal(i); });
+		}
+	}
+}
+
+BoardSim::TickInput BoardSim::record_input(float elapsed) const {
+	TickInput input;
+	input.elapsed = elapsed;
+	input.controls = controls_to_bits(controls);
+	input.cursor_x = cursor.x;
+	input.cursor_y = cursor.y;
+	return input;
+}
+
+void BoardSim::apply_input(TickInput const &input) {
+	controls = controls_from_bits(input.controls);
+	//recorded cursor may come from a larger board; clamp to this one:
+	cursor.x = glm::min(input.cursor_x, board_size.x - 1);
+	cursor.y = glm::min(input.cursor_y, board_size.y - 1);
+}
+
+glm::quat BoardSim::roll_rotation(Controls const &controls, float elapsed) {
+	glm::quat dr = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	float amt = elapsed * 1.0f;
+	if (controls.roll_left) {
+		dr = glm::angleAxis(amt, glm::vec3(0.0f, 1.0f, 0.0f)) * dr;
+	}
+	if (controls.roll_right) {
+		dr = glm::angleAxis(-amt, glm::vec3(0.0f, 1.0f, 0.0f)) * dr;
+	}
+	if (controls.roll_up) {
+		dr = glm::angleAxis(amt, glm::vec3(1.0f, 0.0f, 0.0f)) * dr;
+	}
+	if (controls.roll_down) {
+		dr = glm::angleAxis(-amt, glm::vec3(1.0f, 0.0f, 0.0f)) * dr;
+	}
+	return dr;
+}
+
+void BoardSim::roll_cross(glm::quat *rotations, glm::uvec2 board_size, glm::uvec2 cursor, glm::quat const &dr,
+	MeshId const *meshes, uint64_t *hash) {
+	if (hash) {
+		//same loops as below, but also swap each touched cell's contribution to the hash:
+		auto roll = [&](uint32_t i) {
+			glm::quat &r = rotations[i];
+			*hash ^= cell_hash(i, meshes[i], quantize_rotation(r));
+			r = glm::normalize(dr * r);
+			*hash ^= cell_hash(i, meshes[i], quantize_rotation(r));
+		};
+		for (uint32_t x = 0; x < board_size.x; ++x) {
+			roll(cursor.y * board_size.x + x);
+		}
+		for (uint32_t y = 0; y < board_size.y; ++y) {
+			if (y != cursor.y) roll(y * board_size.x + cursor.x);
+		}
+		return;
+	}
+	for (uint32_t x = 0; x < board_size.x; ++x) {
+		glm::quat &r = rotations[cursor.y * board_size.x + x];
+		r = glm::normalize(dr * r);
+	}
+	for (uint32_t y = 0; y < board_size.y; ++y) {
+		if (y != cursor.y) {
+			glm::quat &r = rotations[y * board_size.x + cursor.x];
+			r = glm::normalize(dr * r);
+		}
+	}
+}
+
+void BoardSim::roll_cross(glm::quat *rotations, CellLayout const &layout, glm::uvec2 cursor, glm::quat const &dr,
+	MeshId const *meshes, uint64_t *hash) {
+	uint32_t width = layout.board_size.x;
+	if (hash) {
+		auto roll = [&](uint32_t cell, uint32_t i) {
+			glm::quat &r = rotations[i];
+			*hash ^= cell_hash(cell, meshes[i], quantize_rotation(r));
+			r = glm::normalize(dr * r);
+			*hash ^= cell_hash(cell, meshes[i], quantize_rotation(r));
+		};
+		layout.for_row(cursor.y, [&](uint32_t x, uint32_t i){ roll(cursor.y * width + x, i); });
+		layout.for_column(cursor.x, [&](uint32_t y, uint32_t i){ if (y != cursor.y) roll(y * width + cursor.x, i); });
+		return;
+	}
+	layout.for_row(cursor.y, [&](uint32_t, uint32_t i){
+		rotations[i] = glm::normalize(dr * rotations[i]);
+	});
+	layout.for_column(cursor.x, [&](uint32_t y, uint32_t i){
+		if (y != cursor.y) rotations[i] = glm::normalize(dr * rotations[i]);
+	});
+}
+
+void BoardSim::roll_cross_discrete(uint8_t *orientations, glm::uvec2 board_size, glm::uvec2 cursor, CubeRotations::Roll roll,
+	MeshId const *meshes, uint64_t *hash) {
+	uint8_t const *table = CubeRotations::tables.roll[roll];
+	if (hash) {
+		for_cross(board_size, cursor, [&](uint32_t i){
+			uint8_t &o = orientations[i];
+			*hash ^= cell_hash(i, meshes[i], quantize_orientation(o));
+			o = table[o];
+			*hash ^= cell_hash(i, meshes[i], quantize_orientation(o));
+		});
+	} else {
+		for_cross(board_size, cursor, [&](uint32_t i){
+			orientations[i] = table[orientations[i]];
+		});
+	}
+}
+
+//splitmix64 finalizer; cheap, well-distributed 64-bit mixing:
+static inline uint64_t mix64(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+uint64_t BoardSim::cell_hash(uint32_t index, MeshId mesh, QuantizedRotation const &rotation) {
+	uint64_t bits;
+	static_assert(sizeof(bits) == sizeof(rotation), "rotation fits in 64 bits");
+	std::memcpy(&bits, &rotation, sizeof(bits));
+	uint64_t h = mix64((uint64_t(index) << 8 | uint64_t(mesh)) + 0x9e3779b97f4a7c15ULL);
+	return mix64(h ^ bits);
+}
+
+BoardSim::Controls BoardSim::controls_from_bits(uint32_t bits) {
+	Controls ret;
+	ret.roll_left = (bits & TickInput::RollLeft) != 0;
+	ret.roll_right = (bits & TickInput::RollRight) != 0;
+	ret.roll_up = (bits & TickInput::RollUp) != 0;
+	ret.roll_down = (bits & TickInput::RollDown) != 0;
+	return ret;
+}
+
+uint32_t BoardSim::controls_to_bits(Controls const &controls) {
+	return (controls.roll_left ? TickInput::RollLeft : 0)
+	     | (controls.roll_right ? TickInput::RollRight : 0)
+	     | (controls.roll_up ? TickInput::RollUp : 0)
+	     | (controls.roll_down ? TickInput::RollDown : 0);
+}
+
+BoardSim::QuantizedRotation BoardSim::quantize_rotation(glm::quat const &rotation) {
+	auto q = [](float f) -> int16_t {
+		return int16_t(std::lround(glm::clamp(f, -1.0f, 1.0f) * 32767.0f));
+	};
+	QuantizedRotation ret;
+	ret.x = q(rotation.x);
+	ret.y = q(rotation.y);
+	ret.z = q(rotation.z);
+	ret.w = q(rotation.w);
+	//pick the sign after quantization, so values that round to zero don't decide it:
+	int16_t lead = (ret.w != 0 ? ret.w : ret.x != 0 ? ret.x : ret.y != 0 ? ret.y : ret.z);
+	if (lead < 0) {
+		ret.x = -ret.x;
+		ret.y = -ret.y;
+		ret.z = -ret.z;
+		ret.w = -ret.w;
+	}
+	return ret;
+}
+
+glm::quat BoardSim::dequantize_rotation(QuantizedRotation const &rotation) {
+	return glm::normalize(glm::quat(
+		rotation.w / 32767.0f,
+		rotation.x / 32767.0f,
+		rotation.y / 32767.0f,
+		rotation.z / 32767.0f
+	));
+}
+
+BoardSim::QuantizedRotation const &BoardSim::quantize_orientation(uint8_t orientation) {
+	struct Table {
+		QuantizedRotation q[CubeRotations::Count];
+		Table() {
+			for (uint32_t i = 0; i < CubeRotations::Count; ++i) {
+				q[i] = quantize_rotation(CubeRotations::to_quat(uint8_t(i)));
+			}
+		}
+	};
+	static Table const table;
+	return table.q[orientation];
+}
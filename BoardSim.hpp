@@ -0,0 +1,232 @@
+#pragma once
+
+#include "CubeRotations.hpp"
+#include "Tweens.hpp"
+#include "SparseRotations.hpp"
+#include "CellLayout.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// The 'BoardSim' struct holds the puzzle board state and the logic that
+// updates it. It does not use OpenGL (or SDL), so it can run headless
+// (e.g., in a simulation server or benchmark).
+
+struct BoardSim {
+	//identifies the mesh sitting on a cell of the board:
+	// (BoardRenderer maps these to actual meshes)
+	enum MeshId : uint8_t {
+		Doll = 0,
+		Egg = 1,
+		Cube = 2,
+		MeshIdCount
+	};
+
+	struct Controls {
+		bool roll_left = false;
+		bool roll_right = false;
+		bool roll_up = false;
+		bool roll_down = false;
+	};
+
+	//TickInput captures everything update() reads for one tick,
+	// so that runs can be recorded and replayed headless:
+	struct TickInput {
+		enum : uint32_t {
+			RollLeft = 1,
+			RollRight = 2,
+			RollUp = 4,
+			RollDown = 8,
+		};
+		float elapsed = 0.0f;
+		uint32_t controls = 0; //bitmask of Roll* flags
+		uint32_t cursor_x = 0;
+		uint32_t cursor_y = 0;
+	};
+	static_assert(sizeof(TickInput) == 16, "TickInput should be packed.");
+
+	//QuantizedRotation stores a rotation as 16-bit fixed point, with sign chosen so the
+	// first nonzero component of (w,x,y,z) is positive
+	// (so q and -q, which are the same rotation, quantize identically):
+	struct QuantizedRotation {
+		int16_t x = 0, y = 0, z = 0, w = 32767;
+	};
+	static_assert(sizeof(QuantizedRotation) == 8, "QuantizedRotation should be packed.");
+
+	//RollAction is one roll that update() performed, in a form that can be applied again
+	// (e.g., when History replays actions after restoring a keyframe):
+	struct RollAction {
+		uint32_t cursor_x = 0, cursor_y = 0; //cross that was rolled (full width, like TickInput's, so any board size works)
+		uint8_t controls = 0; //continuous mode: bitmask of TickInput::Roll* flags (0 if no roll)
+		CubeRotations::Roll roll = CubeRotations::NoRoll; //discrete mode: quarter turn completed
+		uint16_t reserved = 0;
+		float angle = 0.0f; //continuous mode: roll amount (as 'elapsed' in roll_rotation)
+	};
+	static_assert(sizeof(RollAction) == 16, "RollAction should be packed.");
+
+	//reset sets up a board of the given size with randomly chosen meshes
+	// (from a generator seeded with 'seed') and identity rotations.
+	//In 'discrete' mode, every cell is always in one of the 24 cube orientations
+	// and each roll is an (animated) quarter turn.
+	//In 'sparse' mode (continuous only), rotations are kept in 'sparse_rotations' instead of
+	// 'board_rotations', so cells that were never rolled cost (almost) nothing:
+	void reset(glm::uvec2 board_size, uint32_t seed, bool discrete = false, bool sparse = false);
+
+	//set_orientations replaces every cell's orientation (discrete mode only;
+	// e.g., to start from a puzzle in a PuzzleSet):
+	void set_orientations(std::vector< uint8_t > const &orientations);
+	//set_rotations is the continuous-mode counterpart:
+	void set_rotations(std::vector< glm::quat > const &rotations);
+	void set_rotations(SparseRotations const &rotations); //sparse mode only
+
+	//set_goal sets the orientation each cell should reach (a CubeRotations index, or AnyOrientation
+	// for cells that don't matter); an empty goal clears it. reset() also clears the goal:
+	void set_goal(std::vector< uint8_t > const &orientations);
+
+	//true if every cell matches the goal (false if there is no goal):
+	bool solved() const {
+		return !goal_orientations.empty() && goal_matching == goal_orientations.size();
+	}
+
+	//compute_hash hashes the whole board (meshes and quantized rotations) from scratch;
+	// update() keeps 'state_hash' equal to this by rehashing only the cells it touches.
+	//(In sparse mode, only allocated chunks are visited.)
+	uint64_t compute_hash() const;
+
+	//update is called once per tick; rolls the row and column under the cursor
+	// according to the current controls. If 'performed' is non-null, it is set to the roll
+	// applied to the board state this tick (or a default RollAction if there was none):
+	void update(float elapsed, RollAction *performed = nullptr);
+
+	//apply_action applies a roll to the board state immediately (no animation):
+	void apply_action(RollAction const &action);
+
+	//record the input that update(elapsed) would see / set cursor and controls from recorded input:
+	TickInput record_input(float elapsed) const;
+	void apply_input(TickInput const &input);
+
+	//------- board state -------
+
+	glm::uvec2 board_size = glm::uvec2(0,0);
+	uint32_t seed = 0; //seed passed to reset()
+	std::vector< MeshId > board_meshes;
+	std::vector< glm::quat > board_rotations;
+	uint64_t state_hash = 0; //== compute_hash(), maintained incrementally
+
+	//in sparse mode, board_rotations is empty and rotations live here instead:
+	bool sparse = false;
+	SparseRotations sparse_rotations;
+	//sparse mode: hash of the board with every cell at identity (set by reset(), since meshes don't
+	// change after it), so compute_hash() need only visit allocated chunks:
+	uint64_t identity_hash = 0;
+
+	//rotation of cell (x,y), whichever storage is in use:
+	glm::quat rotation(uint32_t x, uint32_t y) const {
+		if (sparse) return sparse_rotations.get(x, y);
+		return board_rotations[y * board_size.x + x];
+	}
+
+	//call fn(x, y, rotation) for every cell, in row-major order, whichever storage is in use
+	// (in sparse mode, looks up each chunk once per row instead of once per cell):
+	template< typename F >
+	void for_each_rotation(F const &fn) const {
+		if (!sparse) {
+			for (uint32_t y = 0; y < board_size.y; ++y) {
+				for (uint32_t x = 0; x < board_size.x; ++x) {
+					fn(x, y, board_rotations[y * board_size.x + x]);
+				}
+			}
+			return;
+		}
+		glm::quat const identity(1.0f, 0.0f, 0.0f, 0.0f);
+		for (uint32_t y = 0; y < board_size.y; ++y) {
+			uint32_t const *chunk_row = &sparse_rotations.chunk_at[(y / SparseRotations::ChunkSize) * sparse_rotations.chunks.x];
+			for (uint32_t cx = 0; cx < sparse_rotations.chunks.x; ++cx) {
+				uint32_t x0 = cx * SparseRotations::ChunkSize;
+				uint32_t x1 = glm::min(x0 + SparseRotations::ChunkSize, board_size.x);
+				if (chunk_row[cx] == SparseRotations::NoChunk) {
+					for (uint32_t x = x0; x < x1; ++x) fn(x, y, identity);
+				} else {
+					glm::quat const *cells = &sparse_rotations.data[chunk_row[cx] * SparseRotations::ChunkCells + (y % SparseRotations::ChunkSize) * SparseRotations::ChunkSize];
+					for (uint32_t x = x0; x < x1; ++x) fn(x, y, cells[x - x0]);
+				}
+			}
+		}
+	}
+
+	//------- discrete mode state -------
+	//In discrete mode, board_orientations is the board state, and board_rotations
+	// is derived from it for drawing (with the cells of an in-flight roll animated by 'tweens').
+
+	bool discrete = false;
+	std::vector< uint8_t > board_orientations; //CubeRotations index per cell
+
+	struct {
+		CubeRotations::Roll roll = CubeRotations::NoRoll; //NoRoll if not rolling
+		glm::uvec2 cursor = glm::uvec2(0,0); //cross being rolled
+		float t = 0.0f; //fraction of quarter turn completed
+	} rolling;
+
+	float roll_duration = 0.25f; //seconds per quarter turn
+
+	Tweens tweens; //animations of in-flight rolls (writes board_rotations)
+
+	glm::uvec2 cursor = glm::uvec2(0,0);
+
+	Controls controls;
+
+	//------- goal tracking -------
+	//update() re-checks only the cells it rolls, so checking for a win is O(changed cells) per tick.
+	//In discrete mode, cells are compared by settled orientation; in continuous mode, a cell
+	// matches if its rotation is within goal_tolerance of the goal orientation.
+
+	enum : uint8_t {
+		AnyOrientation = 0xff,
+	};
+	std::vector< uint8_t > goal_orientations; //per cell; empty if no goal
+	std::vector< uint8_t > goal_matched; //per cell, 1 if the cell matches its goal
+	uint32_t goal_matching = 0; //number of cells matching their goal
+	float goal_tolerance = 0.05f; //radians (continuous mode only)
+
+	//does cell 'i' currently match its goal?
+	bool matches_goal(uint32_t i) const;
+	//re-check cell 'i' and update goal_matched / goal_matching:
+	void update_goal(uint32_t i);
+
+	//------- update logic, usable on boards stored elsewhere -------
+
+	//roll_rotation computes the rotation applied this tick for the given controls
+	// (returns the identity if no roll is active):
+	static glm::quat roll_rotation(Controls const &controls, float elapsed);
+
+	//roll_cross applies 'dr' to every cell on the same row or column as 'cursor'
+	// in a row-major array of board_size.x * board_size.y rotations;
+	// if 'hash' is non-null, it is updated for the touched cells (using 'meshes'):
+	static void roll_cross(glm::quat *rotations, glm::uvec2 board_size, glm::uvec2 cursor, glm::quat const &dr,
+		MeshId const *meshes = nullptr, uint64_t *hash = nullptr);
+
+	//roll_cross for arrays stored in 'layout' (see CellLayout); the hash uses row-major cell
+	// indices whatever the layout, so it matches the hash of the same board stored row-major:
+	static void roll_cross(glm::quat *rotations, CellLayout const &layout, glm::uvec2 cursor, glm::quat const &dr,
+		MeshId const *meshes = nullptr, uint64_t *hash = nullptr);
+
+	//roll_cross_discrete applies a quarter turn to every cell on the same row or column
+	// as 'cursor' in a row-major array of CubeRotations indices (one table lookup per cell);
+	// if 'hash' is non-null, it is updated for the touched cells (using 'meshes'):
+	static void roll_cross_discrete(uint8_t *orientations, glm::uvec2 board_size, glm::uvec2 cursor, CubeRotations::Roll roll,
+		MeshId const *meshes = nullptr, uint64_t *hash = nullptr);
+
+	//cell_hash is the contribution of one cell to the board hash;
+	// the board hash is the xor of cell_hash over all cells:
+	static uint64_t cell_hash(uint32_t index, MeshId mesh, QuantizedRotation const &rotation);
+
+	static Controls controls_from_bits(uint32_t bits);
+	static uint32_t controls_to_bits(Controls const &controls);
+
+	static QuantizedRotation quantize_rotation(glm::quat const &rotation);
+	static QuantizedRotation const &quantize_orientation(uint8_t orientation); //same as quantize_rotation(CubeRotations::to_quat(orientation))
+	static glm::quat dequantize_rotation(QuantizedRotation const &rotation);
+};
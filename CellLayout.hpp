@@ -0,0 +1,81 @@
+#pragma once
+
+#include "morton.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+//CellLayout maps board cells (x,y) to indices in per-cell arrays.
+//
+//RowMajor is the usual y * board_size.x + x: rows are contiguous, but each step down a column
+// jumps a whole row ahead, so a column roll touches a new cache line (and, on big boards, a
+// new page) per cell.
+//Tiled splits the board into TileSize x TileSize tiles stored one after another (row-major by
+// tile), with cells in Z-order (Morton order) inside each tile. Rows and columns then both use
+// two cells per cache line, and a column stays within one 64KB tile for 64 cells instead of
+// touching a new page per cell. Rows lose some of their locality in exchange, so which layout
+// wins depends on the mix of rolls and board size (see layout_bench). Edge tiles are padded,
+// so storage_cells() may exceed the cell count.
+//
+//for_row() and for_column() visit cells with the index math hoisted out of the inner loop;
+// prefer them over index() for anything that walks a whole row or column.
+struct CellLayout {
+	enum Kind : uint8_t {
+		RowMajor = 0,
+		Tiled = 1,
+	};
+	enum : uint32_t {
+		TileSize = 64,
+		TileCells = TileSize * TileSize,
+	};
+
+	CellLayout() = default;
+	CellLayout(Kind kind_, glm::uvec2 board_size_) : kind(kind_), board_size(board_size_),
+		tiles((board_size_ + glm::uvec2(TileSize - 1)) / glm::uvec2(TileSize)) { }
+
+	Kind kind = RowMajor;
+	glm::uvec2 board_size = glm::uvec2(0,0);
+	glm::uvec2 tiles = glm::uvec2(0,0); //board size in tiles (Tiled only)
+
+	//number of array entries needed to hold the board:
+	uint32_t storage_cells() const {
+		if (kind == RowMajor) return board_size.x * board_size.y;
+		return tiles.x * tiles.y * TileCells;
+	}
+
+	uint32_t index(uint32_t x, uint32_t y) const {
+		if (kind == RowMajor) return y * board_size.x + x;
+		return ((y / TileSize) * tiles.x + (x / TileSize)) * TileCells
+			+ morton_index(x % TileSize, y % TileSize);
+	}
+
+	//call fn(x, index) for every cell of row y, in order of x:
+	template< typename F >
+	void for_row(uint32_t y, F const &fn) const {
+		if (kind == RowMajor) {
+			uint32_t row = y * board_size.x;
+			for (uint32_t x = 0; x < board_size.x; ++x) fn(x, row + x);
+			return;
+		}
+		uint32_t base = (y / TileSize) * tiles.x * TileCells + (morton_spread(y % TileSize) << 1);
+		for (uint32_t x0 = 0; x0 < board_size.x; x0 += TileSize, base += TileCells) {
+			uint32_t count = glm::min(uint32_t(TileSize), board_size.x - x0);
+			for (uint32_t lx = 0; lx < count; ++lx) fn(x0 + lx, base + morton_spread(lx));
+		}
+	}
+
+	//call fn(y, index) for every cell of column x, in order of y:
+	template< typename F >
+	void for_column(uint32_t x, F const &fn) const {
+		if (kind == RowMajor) {
+			for (uint32_t y = 0, i = x; y < board_size.y; ++y, i += board_size.x) fn(y, i);
+			return;
+		}
+		uint32_t base = (x / TileSize) * TileCells + morton_spread(x % TileSize);
+		for (uint32_t y0 = 0; y0 < board_size.y; y0 += TileSize, base += tiles.x * TileCells) {
+			uint32_t count = glm::min(uint32_t(TileSize), board_size.y - y0);
+			for (uint32_t ly = 0; ly < count; ++ly) fn(y0 + ly, base + (morton_spread(ly) << 1));
+		}
+	}
+};
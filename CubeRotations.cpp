@@ -0,0 +1,43 @@
+#include "CubeRotations.hpp"
+
+#include "BoardSim.hpp"
+
+namespace CubeRotations {
+
+glm::quat to_quat(uint8_t orientation) {
+	struct Quats {
+		glm::quat q[Count];
+		Quats() {
+			for (uint32_t i = 0; i < Count; ++i) {
+				Matrix const &m = tables.matrices[i];
+				//NOTE: glm matrices are specified in column-major order
+				q[i] = glm::normalize(glm::quat_cast(glm::mat3(
+					m.m[0][0], m.m[1][0], m.m[2][0],
+					m.m[0][1], m.m[1][1], m.m[2][1],
+					m.m[0][2], m.m[1][2], m.m[2][2]
+				)));
+			}
+		}
+	};
+	static Quats const quats;
+	return quats.q[orientation < Count ? orientation : Identity];
+}
+
+glm::quat roll_quat(Roll roll) {
+	float const quarter = 0.5f * 3.1415926535f;
+	if (roll == RollLeft) return glm::angleAxis( quarter, glm::vec3(0.0f, 1.0f, 0.0f));
+	if (roll == RollRight) return glm::angleAxis(-quarter, glm::vec3(0.0f, 1.0f, 0.0f));
+	if (roll == RollUp) return glm::angleAxis( quarter, glm::vec3(1.0f, 0.0f, 0.0f));
+	if (roll == RollDown) return glm::angleAxis(-quarter, glm::vec3(1.0f, 0.0f, 0.0f));
+	return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+}
+
+Roll roll_from_bits(uint32_t bits) {
+	if (bits & BoardSim::TickInput::RollLeft) return RollLeft;
+	if (bits & BoardSim::TickInput::RollRight) return RollRight;
+	if (bits & BoardSim::TickInput::RollUp) return RollUp;
+	if (bits & BoardSim::TickInput::RollDown) return RollDown;
+	return NoRoll;
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+//CubeRotations: the 24 rotations that map a cube onto itself (every 90-degree orientation),
+// each identified by a uint8_t index. Index 0 is the identity.
+//
+//Each rotation is a signed permutation matrix; composition and roll tables are built
+// at compile time, so composing orientations is a single table lookup.
+
+namespace CubeRotations {
+
+	enum : uint8_t {
+		Count = 24,
+		Identity = 0,
+	};
+
+	//the four rolls BoardSim can apply (matching its continuous controls):
+	enum Roll : uint8_t {
+		RollLeft = 0, //+90 degrees about y
+		RollRight = 1, //-90 degrees about y
+		RollUp = 2, //+90 degrees about x
+		RollDown = 3, //-90 degrees about x
+		RollCount,
+		NoRoll = 0xff
+	};
+
+	//3x3 matrix with entries in {-1,0,1}, stored row-major (m[row][col]):
+	struct Matrix {
+		int8_t m[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+	};
+
+	constexpr Matrix multiply(Matrix const &a, Matrix const &b) {
+		Matrix r;
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				int sum = 0;
+				for (int k = 0; k < 3; ++k) sum += a.m[i][k] * b.m[k][j];
+				r.m[i][j] = int8_t(sum);
+			}
+		}
+		return r;
+	}
+
+	constexpr bool equal(Matrix const &a, Matrix const &b) {
+		for (int i = 0; i < 3; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				if (a.m[i][j] != b.m[i][j]) return false;
+			}
+		}
+		return true;
+	}
+
+	//matrix for a quarter turn in the given roll direction:
+	constexpr Matrix roll_matrix(Roll roll) {
+		Matrix r;
+		if (roll == RollLeft) { //+90 about y: x -> -z, z -> x
+			r.m[0][2] = 1; r.m[1][1] = 1; r.m[2][0] = -1;
+		} else if (roll == RollRight) { //-90 about y
+			r.m[0][2] = -1; r.m[1][1] = 1; r.m[2][0] = 1;
+		} else if (roll == RollUp) { //+90 about x: y -> z, z -> -y
+			r.m[0][0] = 1; r.m[1][2] = -1; r.m[2][1] = 1;
+		} else { //RollDown, -90 about x
+			r.m[0][0] = 1; r.m[1][2] = 1; r.m[2][1] = -1;
+		}
+		return r;
+	}
+
+	struct Tables {
+		Matrix matrices[Count];
+		uint8_t compose[Count][Count] = {}; //compose[a][b] == a * b (b applied first)
+		uint8_t inverse[Count] = {};
+		uint8_t roll[RollCount][Count] = {}; //roll[r][o] == roll_matrix(r) * o
+	};
+
+	constexpr uint8_t index_of(Tables const &t, Matrix const &m) {
+		for (uint8_t i = 0; i < Count; ++i) {
+			if (equal(t.matrices[i], m)) return i;
+		}
+		return 0xff; //unreachable: the rotations form a group
+	}
+
+	constexpr Tables make_tables() {
+		Tables t;
+
+		//enumerate signed permutation matrices with determinant +1:
+		int perms[6][3] = {{0,1,2},{0,2,1},{1,0,2},{1,2,0},{2,0,1},{2,1,0}};
+		int perm_parity[6] = {1,-1,-1,1,1,-1};
+		int count = 0;
+		for (int p = 0; p < 6; ++p) {
+			for (int s = 0; s < 8; ++s) {
+				int sx = (s & 1 ? -1 : 1), sy = (s & 2 ? -1 : 1), sz = (s & 4 ? -1 : 1);
+				if (perm_parity[p] * sx * sy * sz != 1) continue;
+				Matrix m;
+				m.m[0][perms[p][0]] = int8_t(sx);
+				m.m[1][perms[p][1]] = int8_t(sy);
+				m.m[2][perms[p][2]] = int8_t(sz);
+				t.matrices[count++] = m;
+			}
+		}
+
+		for (uint8_t a = 0; a < Count; ++a) {
+			for (uint8_t b = 0; b < Count; ++b) {
+				t.compose[a][b] = index_of(t, multiply(t.matrices[a], t.matrices[b]));
+				if (t.compose[a][b] == Identity) t.inverse[a] = b;
+			}
+		}
+		for (uint8_t r = 0; r < RollCount; ++r) {
+			uint8_t ri = index_of(t, roll_matrix(Roll(r)));
+			for (uint8_t o = 0; o < Count; ++o) {
+				t.roll[r][o] = t.compose[ri][o];
+			}
+		}
+		return t;
+	}
+
+	constexpr Tables tables = make_tables();
+
+	static_assert(tables.compose[Identity][5] == 5 && tables.compose[5][Identity] == 5, "index 0 is the identity");
+	static_assert(tables.roll[RollLeft][tables.roll[RollRight][7]] == 7, "opposite rolls cancel");
+	static_assert(tables.roll[RollUp][tables.roll[RollUp][tables.roll[RollUp][tables.roll[RollUp][3]]]] == 3, "four quarter turns are the identity");
+
+	//quaternion for an orientation index (for drawing and for hashing):
+	glm::quat to_quat(uint8_t orientation);
+
+	//quaternion for a quarter turn in the given direction:
+	glm::quat roll_quat(Roll roll);
+
+	//Roll for the given bitmask of BoardSim::TickInput::Roll* flags (first set flag wins):
+	Roll roll_from_bits(uint32_t bits);
+}
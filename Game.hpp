@@ -1,18 +1,21 @@
 #pragma once
 
-#include "GL.hpp"
+#include "BoardSim.hpp"
+#include "BoardRenderer.hpp"
+#include "SnapshotRing.hpp"
+#include "Replay.hpp"
+#include "History.hpp"
 
 #include <SDL.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/quaternion.hpp>
 
-#include <vector>
+#include <memory>
 
 // The 'Game' struct holds all of the game-relevant state,
 // and is called by the main loop.
 
 struct Game {
-	//Game creates OpenGL resources (i.e. vertex buffer objects) in its
+	//Game creates OpenGL resources (via its BoardRenderer) in its
 	//constructor and frees them in its destructor.
 	Game();
 	~Game();
@@ -30,55 +33,21 @@ struct Game {
 
 	//------- opengl resources -------
 
-	//shader program that draws lit objects with vertex colors:
-	struct {
-		GLuint program = -1U; //program object
-
-		//uniform locations:
-		GLuint object_to_clip_mat4 = -1U;
-		GLuint object_to_light_mat4x3 = -1U;
-		GLuint normal_to_light_mat3 = -1U;
-		GLuint sun_direction_vec3 = -1U;
-		GLuint sun_color_vec3 = -1U;
-		GLuint sky_direction_vec3 = -1U;
-		GLuint sky_color_vec3 = -1U;
-
-		//attribute locations:
-		GLuint Position_vec4 = -1U;
-		GLuint Normal_vec3 = -1U;
-		GLuint Color_vec4 = -1U;
-	} simple_shading;
-
-	//mesh data, stored in a vertex buffer:
-	GLuint meshes_vbo = -1U; //vertex buffer holding mesh data
-
-	//The location of each mesh in the meshes vertex buffer:
-	struct Mesh {
-		GLint first = 0;
-		GLsizei count = 0;
-	};
-
-	Mesh tile_mesh;
-	Mesh cursor_mesh;
-	Mesh doll_mesh;
-	Mesh egg_mesh;
-	Mesh cube_mesh;
-
-	GLuint meshes_for_simple_shading_vao = -1U; //vertex array object that describes how to connect the meshes_vbo to the simple_shading_program
+	BoardRenderer renderer;
 
 	//------- game state -------
 
-	glm::uvec2 board_size = glm::uvec2(5,4);
-	std::vector< Mesh const * > board_meshes;
-	std::vector< glm::quat > board_rotations;
+	BoardSim sim;
 
-	glm::uvec2 cursor = glm::vec2(0,0);
+	bool was_solved = false; //sim.solved() as of the last update (to announce wins once)
 
-	struct {
-		bool roll_left = false;
-		bool roll_right = false;
-		bool roll_up = false;
-		bool roll_down = false;
-	} controls;
+	//undo/redo for rolls (Z / Y keys); reset this if sim is reset:
+	History history;
 
+	//if non-null, input and resulting board hash for each tick are appended here (for replaying headless):
+	Replay *record_to = nullptr;
+
+	//if non-null, the board is not simulated locally; instead, the latest
+	//snapshot published by another process (e.g., 'server --publish') is shown:
+	std::unique_ptr< SnapshotRing::Reader > view_from;
 };
@@ -0,0 +1,164 @@
+#include "History.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//can 'next' be folded into 'prev' by adding angles? (continuous rolls of the same cross about one axis)
+static bool mergeable(BoardSim::RollAction const &prev, BoardSim::RollAction const &next) {
+	uint32_t horizontal = BoardSim::TickInput::RollLeft | BoardSim::TickInput::RollRight;
+	uint32_t vertical = BoardSim::TickInput::RollUp | BoardSim::TickInput::RollDown;
+	bool single_axis = (next.controls & horizontal) == 0 || (next.controls & vertical) == 0;
+	return single_axis
+		&& next.roll == CubeRotations::NoRoll && prev.roll == CubeRotations::NoRoll
+		&& next.controls == prev.controls
+		&& next.cursor_x == prev.cursor_x && next.cursor_y == prev.cursor_y;
+}
+
+History::History(uint32_t capacity_, uint32_t keyframe_interval_)
+	: capacity(std::max(capacity_, 1U)), requested_interval(keyframe_interval_) {
+	ring.resize(capacity);
+}
+
+void History::reset(BoardSim const &sim) {
+	keyframe_interval = requested_interval;
+	if (keyframe_interval == 0) {
+		size_t cells = size_t(sim.board_size.x) * sim.board_size.y;
+		size_t cell_bytes = (sim.discrete ? sizeof(uint8_t) : sizeof(glm::quat));
+		size_t cross_cells = std::max(1U, sim.board_size.x + sim.board_size.y - 1);
+		size_t keyframe_bytes = KeyframeOverhead + cells * cell_bytes;
+		//bytes in a keyframe / bytes a roll touches:
+		size_t interval = keyframe_bytes / (cross_cells * cell_bytes);
+		//keyframes should use at most half of what an action saves over a snapshot:
+		size_t snapshot_bytes = cells * cell_bytes;
+		if (snapshot_bytes > sizeof(BoardSim::RollAction)) {
+			interval = std::max(interval, 2 * keyframe_bytes / (snapshot_bytes - sizeof(BoardSim::RollAction)) + 1);
+		} else {
+			interval = capacity;
+		}
+		keyframe_interval = uint32_t(std::min< size_t >(std::max< size_t >(interval, 16), capacity));
+	}
+	//the ring must span at least one keyframe interval:
+	keyframe_interval = std::min(keyframe_interval, capacity);
+
+	first = current = end = 0;
+	open = false;
+	keyframes.clear();
+	add_keyframe(sim, 0);
+}
+
+void History::add_keyframe(BoardSim const &sim, uint64_t index) {
+	keyframes.emplace_back();
+	Keyframe &keyframe = keyframes.back();
+	keyframe.index = index;
+	std::vector< uint8_t > &state = keyframe.state;
+	if (sim.discrete) {
+		state = sim.board_orientations;
+	} else if (sim.sparse) {
+		//[chunk count][chunk_slot per chunk][rotations per chunk]:
+		SparseRotations const &sparse = sim.sparse_rotations;
+		uint32_t count = sparse.chunk_count();
+		state.resize(sizeof(uint32_t) + count * sizeof(uint32_t) + sparse.data.size() * sizeof(glm::quat));
+		std::memcpy(state.data(), &count, sizeof(uint32_t));
+		if (count) {
+			std::memcpy(state.data() + sizeof(uint32_t), sparse.chunk_slot.data(), count * sizeof(uint32_t));
+			std::memcpy(state.data() + sizeof(uint32_t) + count * sizeof(uint32_t), sparse.data.data(), sparse.data.size() * sizeof(glm::quat));
+		}
+	} else {
+		state.resize(sim.board_rotations.size() * sizeof(glm::quat));
+		std::memcpy(state.data(), sim.board_rotations.data(), state.size());
+	}
+}
+
+void History::restore_keyframe(Keyframe const &keyframe, BoardSim *sim) {
+	std::vector< uint8_t > const &state = keyframe.state;
+	if (sim->discrete) {
+		sim->set_orientations(state);
+	} else if (sim->sparse) {
+		uint32_t count = 0;
+		std::memcpy(&count, state.data(), sizeof(uint32_t));
+		SparseRotations sparse;
+		sparse.reset(sim->board_size);
+		if (count) {
+			sparse.chunk_slot.resize(count);
+			std::memcpy(sparse.chunk_slot.data(), state.data() + sizeof(uint32_t), count * sizeof(uint32_t));
+			sparse.data.resize(size_t(count) * SparseRotations::ChunkCells);
+			std::memcpy(sparse.data.data(), state.data() + sizeof(uint32_t) + count * sizeof(uint32_t), sparse.data.size() * sizeof(glm::quat));
+			for (uint32_t c = 0; c < count; ++c) {
+				sparse.chunk_at[sparse.chunk_slot[c]] = c;
+			}
+		}
+		sim->set_rotations(sparse);
+	} else {
+		std::vector< glm::quat > rotations(state.size() / sizeof(glm::quat));
+		std::memcpy(rotations.data(), state.data(), state.size());
+		sim->set_rotations(rotations);
+	}
+}
+
+void History::record(BoardSim const &sim, BoardSim::RollAction const &action) {
+	if (action.controls == 0 && action.roll == CubeRotations::NoRoll) {
+		open = false; //no roll this tick; the next roll is a new action
+		return;
+	}
+
+	//a new action replaces anything that could have been redone:
+	if (current < end) {
+		end = current;
+		while (keyframes.back().index > end) keyframes.pop_back();
+		open = false;
+	}
+
+	if (open && mergeable(action_at(end - 1), action)) {
+		action_at(end - 1).angle += action.angle;
+		return;
+	}
+
+	action_at(end) = action;
+	end += 1;
+	current = end;
+	open = (action.roll == CubeRotations::NoRoll);
+
+	if (end % keyframe_interval == 0) {
+		add_keyframe(sim, end);
+		open = false; //keyframe holds the state after this action; don't extend it
+	}
+
+	//ring full: drop everything before the second-oldest keyframe:
+	if (end - first > capacity) {
+		keyframes.pop_front();
+		first = keyframes.front().index;
+	}
+}
+
+bool History::undo(BoardSim *sim) {
+	if (current == first) return false;
+	open = false;
+	uint64_t target = current - 1;
+
+	//latest keyframe at or before target, then re-apply the actions after it:
+	auto keyframe = keyframes.rbegin();
+	while (keyframe->index > target) ++keyframe;
+	restore_keyframe(*keyframe, sim);
+	for (uint64_t i = keyframe->index; i < target; ++i) {
+		sim->apply_action(action_at(i));
+	}
+
+	current = target;
+	return true;
+}
+
+bool History::redo(BoardSim *sim) {
+	if (current == end) return false;
+	open = false;
+	sim->apply_action(action_at(current));
+	current += 1;
+	return true;
+}
+
+size_t History::memory_bytes() const {
+	size_t bytes = ring.capacity() * sizeof(BoardSim::RollAction);
+	for (auto const &keyframe : keyframes) {
+		bytes += KeyframeOverhead + keyframe.state.capacity();
+	}
+	return bytes;
+}
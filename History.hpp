@@ -0,0 +1,71 @@
+#pragma once
+
+#include "BoardSim.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+//History provides undo/redo for a BoardSim by logging the rolls it performs
+// (BoardSim::RollAction, 16 bytes each) in a fixed-size ring buffer,
+// plus a full snapshot of the board ("keyframe") every 'keyframe_interval' actions.
+//
+//Undo restores the nearest keyframe at or before the target and re-applies the actions
+// after it, so rewinding costs at most keyframe_interval action applications no matter
+// how long the history is. Redo re-applies one action.
+//By default the interval is the number of rolls that touch as many cells as a keyframe holds,
+// so keyframes cost about as much memory as logging each roll's cells would, and replaying
+// between keyframes costs about as much as restoring one. On small boards, where a keyframe is
+// mostly fixed overhead, the interval is stretched so the history stays well under the size of
+// a board snapshot per action.
+//
+//In continuous mode, consecutive ticks that roll the same cross about a single axis are
+// merged into one action (so one undo reverts one key press, not one frame).
+//When the ring is full, the oldest keyframe and the actions before the next keyframe are dropped.
+struct History {
+	//keyframe_interval == 0 picks an interval from the board size at reset():
+	History(uint32_t capacity = 10000, uint32_t keyframe_interval = 0);
+
+	//start a new (empty) history from the board's current state
+	// (call whenever the board is reset or replaced, and before the first record()):
+	void reset(BoardSim const &sim);
+
+	//record the action BoardSim::update() reported performing (default RollAction if none);
+	// recording a roll discards anything that could have been redone:
+	void record(BoardSim const &sim, BoardSim::RollAction const &action);
+
+	//step back / forward one action; return false if there is nothing to undo / redo:
+	bool undo(BoardSim *sim);
+	bool redo(BoardSim *sim);
+
+	//bytes used by the action ring and keyframes:
+	size_t memory_bytes() const;
+
+	//------- internals -------
+
+	struct Keyframe {
+		uint64_t index = 0; //board state after this many actions
+		std::vector< uint8_t > state; //orientations, rotations, or sparse chunks, depending on the board's mode
+	};
+	//memory a keyframe costs beyond its state bytes (the struct, plus a typical heap block header):
+	enum : uint32_t { KeyframeOverhead = sizeof(Keyframe) + 16 };
+
+	uint32_t capacity;
+	uint32_t requested_interval; //as passed to the constructor
+	uint32_t keyframe_interval = 1; //in use since reset()
+
+	std::vector< BoardSim::RollAction > ring; //action i is at ring[i % capacity]
+	std::deque< Keyframe > keyframes; //oldest first; keyframes.front().index == first
+
+	uint64_t first = 0; //oldest action kept
+	uint64_t current = 0; //actions [first,current) are applied to the board
+	uint64_t end = 0; //actions [current,end) can be redone
+	bool open = false; //can the action at end-1 still be extended by merging?
+
+	void add_keyframe(BoardSim const &sim, uint64_t index);
+	void restore_keyframe(Keyframe const &keyframe, BoardSim *sim);
+	BoardSim::RollAction &action_at(uint64_t index) { return ring[index % capacity]; }
+};
@@ -0,0 +1,82 @@
+#include "HugePages.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace HugePages {
+
+char const *name(Source source) {
+	if (source == ExplicitPages) return "hugetlbfs";
+	if (source == TransparentPages) return "transparent";
+	return "regular";
+}
+
+static inline size_t round_up(size_t value, size_t align) {
+	return (value + align - 1) / align * align;
+}
+
+#if defined(__linux__)
+
+Block::Block(size_t bytes_, Policy policy) : bytes(round_up(bytes_, HugePageBytes)) {
+	if (policy == Explicit) {
+		//hugetlbfs mappings are huge-page aligned already:
+		mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mapping != MAP_FAILED) {
+			mapping_bytes = bytes;
+			data = mapping;
+			source = ExplicitPages;
+			return;
+		}
+		//(most likely, not enough huge pages reserved)
+		mapping = nullptr;
+	}
+
+	//over-allocate by one huge page so the block can start on a huge page boundary
+	// (the kernel can only use huge pages for aligned 2MB ranges):
+	mapping_bytes = bytes + HugePageBytes;
+	mapping = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		throw std::runtime_error("Failed to map " + std::to_string(mapping_bytes) + " bytes: " + std::strerror(errno));
+	}
+	data = reinterpret_cast< void * >(round_up(reinterpret_cast< uintptr_t >(mapping), HugePageBytes));
+
+	//advise before first touch, since pages are chosen when they fault in:
+	if (policy != Off && madvise(data, bytes, MADV_HUGEPAGE) == 0) {
+		source = TransparentPages;
+	} else {
+		if (policy == Off) madvise(data, bytes, MADV_NOHUGEPAGE); //(in case THP is set to 'always')
+		source = RegularPages;
+	}
+}
+
+Block::~Block() {
+	if (mapping) munmap(mapping, mapping_bytes);
+}
+
+#else
+
+Block::Block(size_t bytes_, Policy) : bytes(round_up(bytes_, HugePageBytes)) {
+	mapping_bytes = bytes + HugePageBytes;
+	mapping = std::calloc(1, mapping_bytes);
+	if (!mapping) {
+		throw std::runtime_error("Failed to allocate " + std::to_string(mapping_bytes) + " bytes.");
+	}
+	data = reinterpret_cast< void * >(round_up(reinterpret_cast< uintptr_t >(mapping), HugePageBytes));
+	source = RegularPages;
+}
+
+Block::~Block() {
+	std::free(mapping);
+}
+
+#endif
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//HugePages allocates large blocks (e.g., board storage) backed by 2MB pages where the OS allows,
+// so walking a multi-gigabyte board -- especially down columns, a row apart per cell -- needs
+// far fewer TLB entries than with 4KB pages.
+//
+//Two kinds of huge pages are supported (Linux only; elsewhere, blocks use regular pages):
+// - Explicit: hugetlbfs pages (mmap MAP_HUGETLB), which must be reserved by the administrator
+//   beforehand (e.g., 'sysctl vm.nr_hugepages=1024'); allocation fails if there are too few.
+// - Transparent: regular anonymous memory marked with madvise(MADV_HUGEPAGE), which the kernel
+//   backs with huge pages when it can (needs transparent_hugepage set to 'always' or 'madvise').
+//Each policy falls back to the next-weaker kind rather than failing, and the Block records
+// what it actually got.
+
+namespace HugePages {
+	enum Policy : uint8_t {
+		Off, //regular pages (and, on Linux, opt out of transparent huge pages)
+		Transparent, //transparent huge pages, else regular pages
+		Explicit, //hugetlbfs pages, else transparent huge pages, else regular pages
+	};
+
+	//what a Block is actually backed by:
+	enum Source : uint8_t {
+		RegularPages,
+		TransparentPages,
+		ExplicitPages,
+	};
+
+	char const *name(Source source);
+
+	enum : size_t { HugePageBytes = 2 * 1024 * 1024 };
+
+	//a zero-filled block of at least 'bytes' bytes, aligned to HugePageBytes:
+	struct Block {
+		Block(size_t bytes, Policy policy);
+		~Block();
+		Block(Block const &) = delete;
+		Block &operator=(Block const &) = delete;
+
+		void *data = nullptr;
+		size_t bytes = 0; //usable size (bytes requested, rounded up to a whole number of huge pages)
+		Source source = RegularPages;
+
+		//internals: the actual mapping (which may start before 'data', for alignment):
+		void *mapping = nullptr;
+		size_t mapping_bytes = 0;
+	};
+}
@@ -0,0 +1,161 @@
+#include "MappedChunks.hpp"
+
+#include "crc32c.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#if defined(_WIN32)
+//no mmap; files are read into an aligned block.
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedChunks::MappedChunks(std::string const &path_, bool verify) : path(path_) {
+#if defined(_WIN32)
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open '" + path + "'.");
+	}
+	read(file);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open '" + path + "': " + std::strerror(errno));
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to stat '" + path + "'.");
+	}
+	bytes = size_t(info.st_size);
+	if (bytes > 0) {
+		mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			mapping = nullptr;
+			close(fd);
+			throw std::runtime_error("Failed to map '" + path + "': " + std::strerror(errno));
+		}
+		//(chunks are mostly read front to back, once):
+		madvise(mapping, bytes, MADV_SEQUENTIAL);
+		base = reinterpret_cast< uint8_t const * >(mapping);
+	}
+	close(fd);
+#endif
+	parse(verify);
+}
+
+MappedChunks::MappedChunks(std::istream &from, bool verify) : path("(stream)") {
+	read(from);
+	parse(verify);
+}
+
+void MappedChunks::read(std::istream &from) {
+	std::streampos at = from.tellg();
+	from.seekg(0, std::ios::end);
+	std::streampos end = from.tellg();
+	from.seekg(at);
+	if (std::streamoff(at) < 0 || std::streamoff(end) < std::streamoff(at)) {
+		throw std::runtime_error("Failed to find the size of '" + path + "'.");
+	}
+	bytes = size_t(end - at);
+
+	//place the data so that addresses are aligned where file offsets are:
+	block.reset(new char[bytes + 2 * ChunkAlignment]);
+	uintptr_t start = reinterpret_cast< uintptr_t >(block.get());
+	size_t offset = size_t(at) % ChunkAlignment;
+	char *data = block.get() + ((ChunkAlignment + offset - start % ChunkAlignment) % ChunkAlignment);
+	if (!from.read(data, bytes)) {
+		block.reset();
+		throw std::runtime_error("Failed to read '" + path + "'.");
+	}
+	base = reinterpret_cast< uint8_t const * >(data);
+}
+
+void MappedChunks::parse(bool verify) {
+	//walk the chunks (cleaning up here on failure, since the destructor won't run):
+	try {
+		size_t at = 0;
+		while (at < bytes) {
+			ChunkHeader header;
+			if (bytes - at < sizeof(header)) {
+				throw std::runtime_error("Truncated chunk header in '" + path + "'.");
+			}
+			std::memcpy(&header, base + at, sizeof(header));
+			at += sizeof(header);
+
+			Chunk chunk;
+			chunk.magic = std::string(header.magic, 4);
+			chunk.size = header.size & ~uint32_t(ChunkChecksumBit);
+			chunk.checksummed = (header.size & ChunkChecksumBit) != 0;
+			chunk.data = base + at;
+			size_t trailer = (chunk.checksummed ? 4 : 0);
+			if (bytes - at < chunk.size + trailer) {
+				throw std::runtime_error("Truncated chunk '" + chunk.magic + "' in '" + path + "'.");
+			}
+			at += chunk.size + trailer;
+
+			if (chunk.checksummed && verify) {
+				uint32_t expected;
+				std::memcpy(&expected, chunk.data + chunk.size, 4);
+				if (crc32c(chunk.data, chunk.size) != expected) {
+					throw std::runtime_error("Checksum mismatch in chunk '" + chunk.magic + "' of '" + path + "'.");
+				}
+			}
+
+			if (chunk.magic == "chk1") {
+				ChunkFileHeader file_header;
+				if (chunks.size() != 0 || version != 0 || chunk.size != sizeof(file_header)) {
+					throw std::runtime_error("Misplaced or malformed file header in '" + path + "'.");
+				}
+				std::memcpy(&file_header, chunk.data, sizeof(file_header));
+				check_chunk_file_header(file_header);
+				version = file_header.version;
+			} else if (chunk.magic != "pad0") {
+				if (version != 0 && reinterpret_cast< uintptr_t >(chunk.data) % ChunkAlignment != 0) {
+					throw std::runtime_error("Chunk '" + chunk.magic + "' of '" + path + "' is not aligned.");
+				}
+				chunks.emplace_back(std::move(chunk));
+			}
+		}
+	} catch (...) {
+		unmap();
+		throw;
+	}
+}
+
+MappedChunks::~MappedChunks() {
+	unmap();
+}
+
+void MappedChunks::unmap() {
+#if !defined(_WIN32)
+	if (mapping) {
+		munmap(mapping, bytes);
+	}
+#endif
+	mapping = nullptr;
+	block.reset();
+	base = nullptr;
+}
+
+void MappedChunks::touch() const {
+	uint8_t sum = 0;
+	for (size_t at = 0; at < bytes; at += 4096) {
+		sum += base[at];
+	}
+	volatile uint8_t sink = sum; //(so the reads aren't optimized out)
+	(void)sink;
+}
+
+MappedChunks::Chunk const *MappedChunks::find(std::string const &magic, size_t from) const {
+	for (size_t i = from; i < chunks.size(); ++i) {
+		if (chunks[i].magic == magic) return &chunks[i];
+	}
+	return nullptr;
+}
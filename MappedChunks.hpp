@@ -0,0 +1,68 @@
+#pragma once
+
+#include "chunk_header.hpp"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+//MappedChunks memory-maps a chunk file (see chunk_header.hpp) read-only and finds its chunks,
+// so their data can be used in place: no read into a buffer, and no copy on the way to the GPU.
+//In aligned (revision 1) files every chunk's data starts on a ChunkAlignment boundary, so it
+// can be handed straight to SIMD code; in older files, data is only as aligned as it happens to be
+// (data_as() checks that it suits the type asked for).
+//Chunks with checksums are verified when the file is mapped (unless 'verify' is false).
+//(Where memory mapping isn't available -- Windows, for now -- the file is read into an aligned block instead.)
+//
+//MappedChunks can also read every remaining chunk of a stream with one large read (rather than a
+// read per chunk header and per chunk, as read_chunk does), placed so that aligned file offsets
+// are aligned addresses.
+struct MappedChunks {
+	explicit MappedChunks(std::string const &path, bool verify = true); //throws on failure
+	explicit MappedChunks(std::istream &from, bool verify = true); //reads to the end of 'from'; throws on failure
+	~MappedChunks();
+	MappedChunks(MappedChunks const &) = delete;
+	MappedChunks &operator=(MappedChunks const &) = delete;
+
+	struct Chunk {
+		std::string magic;
+		uint8_t const *data = nullptr;
+		size_t size = 0; //bytes
+		bool checksummed = false;
+	};
+	std::vector< Chunk > chunks; //in file order, not including the file header or padding
+
+	uint32_t version = 0; //0 for unaligned files, otherwise ChunkFileHeader::version
+
+	//the first chunk with a given magic number at or after chunks[from] (nullptr if none):
+	Chunk const *find(std::string const &magic, size_t from = 0) const;
+
+	//read every page of the file once (e.g., on a worker thread, so later users of the data don't wait on the disk):
+	void touch() const;
+
+	//chunk data as an array of T (throws if the size or alignment doesn't fit T):
+	template< typename T >
+	static T const *data_as(Chunk const &chunk, size_t *count) {
+		if (chunk.size % sizeof(T) != 0) {
+			throw std::runtime_error("Size of chunk '" + chunk.magic + "' not divisible by element size.");
+		}
+		if (reinterpret_cast< uintptr_t >(chunk.data) % alignof(T) != 0) {
+			throw std::runtime_error("Chunk '" + chunk.magic + "' is not aligned for its element type.");
+		}
+		*count = chunk.size / sizeof(T);
+		return reinterpret_cast< T const * >(chunk.data);
+	}
+
+	std::string path;
+	uint8_t const *base = nullptr; //start of the data: 'mapping', or within 'block'
+	size_t bytes = 0;
+	void *mapping = nullptr; //if memory-mapped
+	std::unique_ptr< char[] > block; //if read
+	void read(std::istream &from); //read to the end of 'from' into 'block'
+	void parse(bool verify); //fill in 'chunks'
+	void unmap(); //(called by the destructor)
+};
@@ -0,0 +1,67 @@
+#include "MaxRects.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+MaxRects::MaxRects(glm::uvec2 size_) : size(size_) {
+	free.emplace_back(Rect{glm::uvec2(0), size});
+}
+
+bool MaxRects::insert(glm::uvec2 want, glm::uvec2 *origin) {
+	if (want.x == 0 || want.y == 0) {
+		*origin = glm::uvec2(0);
+		return true;
+	}
+
+	//best short side fit (ties broken by long side):
+	uint32_t best = -1U;
+	uint32_t best_short = -1U;
+	uint32_t best_long = -1U;
+	for (uint32_t i = 0; i < free.size(); ++i) {
+		glm::uvec2 room = free[i].max - free[i].min;
+		if (room.x < want.x || room.y < want.y) continue;
+		uint32_t leftover_short = std::min(room.x - want.x, room.y - want.y);
+		uint32_t leftover_long = std::max(room.x - want.x, room.y - want.y);
+		if (leftover_short < best_short || (leftover_short == best_short && leftover_long < best_long)) {
+			best = i;
+			best_short = leftover_short;
+			best_long = leftover_long;
+		}
+	}
+	if (best == -1U) return false;
+
+	Rect placed{free[best].min, free[best].min + want};
+	*origin = placed.min;
+	used = glm::max(used, placed.max);
+
+	//split every free rectangle that overlaps the placed one into the (up to four) maximal pieces around it:
+	std::vector< Rect > next;
+	next.reserve(free.size() + 4);
+	for (Rect const &r : free) {
+		if (placed.min.x >= r.max.x || placed.max.x <= r.min.x || placed.min.y >= r.max.y || placed.max.y <= r.min.y) {
+			next.emplace_back(r);
+			continue;
+		}
+		if (placed.min.x > r.min.x) next.emplace_back(Rect{r.min, glm::uvec2(placed.min.x, r.max.y)});
+		if (placed.max.x < r.max.x) next.emplace_back(Rect{glm::uvec2(placed.max.x, r.min.y), r.max});
+		if (placed.min.y > r.min.y) next.emplace_back(Rect{r.min, glm::uvec2(r.max.x, placed.min.y)});
+		if (placed.max.y < r.max.y) next.emplace_back(Rect{glm::uvec2(r.min.x, placed.max.y), r.max});
+	}
+
+	//drop free rectangles contained in others (keeping one of any identical pair):
+	auto contains = [](Rect const &a, Rect const &b) {
+		return a.min.x <= b.min.x && a.min.y <= b.min.y && a.max.x >= b.max.x && a.max.y >= b.max.y;
+	};
+	free.clear();
+	for (uint32_t i = 0; i < next.size(); ++i) {
+		bool redundant = false;
+		for (uint32_t j = 0; j < next.size() && !redundant; ++j) {
+			if (i == j || !contains(next[j], next[i])) continue;
+			//identical rectangles contain each other; keep only the first:
+			redundant = !(contains(next[i], next[j]) && i < j);
+		}
+		if (!redundant) free.emplace_back(next[i]);
+	}
+
+	return true;
+}
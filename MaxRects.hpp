@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+//MaxRects packs rectangles into a fixed-size bin (e.g., textures into an atlas) with the
+// "maximal rectangles" method: it keeps every maximal empty rectangle (they may overlap),
+// places each new rectangle in the free one it fits most snugly (best short side fit),
+// then splits every free rectangle the placement overlaps and drops any free rectangle
+// contained in another.
+//Packing tends to be tightest when rectangles are inserted largest first.
+struct MaxRects {
+	explicit MaxRects(glm::uvec2 size);
+
+	//place a rectangle of 'size'; returns false if it doesn't fit anywhere:
+	bool insert(glm::uvec2 size, glm::uvec2 *origin);
+
+	//smallest size containing every placed rectangle:
+	glm::uvec2 used = glm::uvec2(0);
+
+	//------- internals -------
+
+	struct Rect {
+		glm::uvec2 min; //inclusive
+		glm::uvec2 max; //exclusive
+	};
+
+	glm::uvec2 size;
+	std::vector< Rect > free;
+};
@@ -0,0 +1,211 @@
+#include "MeshVertices.hpp"
+
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+uint32_t MeshVertices::type_size(uint32_t type) {
+	switch (type) {
+		case Byte: case UnsignedByte: return 1;
+		case Short: case UnsignedShort: case HalfFloat: return 2;
+		case Int: case UnsignedInt: case Float: return 4;
+		default: return 0;
+	}
+}
+
+MeshVertices::Attribute const *MeshVertices::find(std::string const &name) const {
+	for (auto const &attribute : attributes) {
+		if (attribute.name == name) return &attribute;
+	}
+	return nullptr;
+}
+
+void MeshVertices::read(std::istream &from) {
+	attributes.clear();
+	streams.clear();
+	palette.clear();
+
+	auto add_attribute = [this](std::string const &name, uint32_t type, uint32_t count, bool normalized, bool integer, uint32_t stream, uint32_t offset) {
+		Attribute attribute;
+		attribute.name = name;
+		attribute.type = type;
+		attribute.count = count;
+		attribute.normalized = normalized;
+		attribute.integer = integer;
+		attribute.stream = stream;
+		attribute.offset = offset;
+		attributes.emplace_back(attribute);
+	};
+	auto add_stream = [this,&from](std::string const &magic, uint32_t stride) {
+		Stream stream;
+		stream.magic = magic;
+		stream.stride = stride;
+		read_chunk(from, magic, &stream.data);
+		streams.emplace_back(std::move(stream));
+	};
+
+	std::string magic = peek_chunk_magic(from);
+	if (magic == "dat0") {
+		layout = Colors;
+		add_stream("dat0", 28);
+		add_attribute("Position", Float, 3, false, false, 0, 0);
+		add_attribute("Normal", Float, 3, false, false, 0, 12);
+		add_attribute("Color", UnsignedByte, 4, true, false, 0, 24);
+	} else if (magic == "dat1") {
+		layout = Paletted;
+		add_stream("dat1", 24);
+		read_chunk(from, "pal0", &palette);
+		add_stream("cix0", 1);
+		add_attribute("Position", Float, 3, false, false, 0, 0);
+		add_attribute("Normal", Float, 3, false, false, 0, 12);
+		add_attribute("ColorIndex", UnsignedByte, 1, false, true, 1, 0);
+	} else {
+		layout = Schema;
+		std::vector< AttributeEntry > entries;
+		read_chunk(from, "vsc0", &entries);
+		//streams are stored in order of first mention:
+		std::vector< std::pair< std::string, uint32_t > > stream_strides;
+		for (AttributeEntry const &e : entries) {
+			std::string name(e.name, std::find(e.name, e.name + sizeof(e.name), '\0'));
+			std::string chunk(e.chunk, 4);
+			if (name.empty()) {
+				throw std::runtime_error("vertex attribute without a name.");
+			}
+			if (type_size(e.type) == 0 || e.count < 1 || e.count > 4) {
+				throw std::runtime_error("vertex attribute '" + name + "' has an unknown type or component count.");
+			}
+			if (e.integer && (e.type == Float || e.type == HalfFloat || e.normalized)) {
+				throw std::runtime_error("vertex attribute '" + name + "' can't be both integer and floating point.");
+			}
+			if (e.stride == 0 || uint64_t(e.offset) + type_size(e.type) * e.count > e.stride) {
+				throw std::runtime_error("vertex attribute '" + name + "' does not fit in its stride.");
+			}
+			uint32_t stream = 0;
+			while (stream < stream_strides.size() && stream_strides[stream].first != chunk) ++stream;
+			if (stream == stream_strides.size()) {
+				stream_strides.emplace_back(chunk, e.stride);
+			} else if (stream_strides[stream].second != e.stride) {
+				throw std::runtime_error("vertex attributes in chunk '" + chunk + "' disagree about its stride.");
+			}
+			add_attribute(name, e.type, e.count, e.normalized != 0, e.integer != 0, stream, e.offset);
+		}
+		for (auto const &s : stream_strides) {
+			add_stream(s.first, s.second);
+		}
+		if (peek_chunk_magic(from) == "pal0") {
+			read_chunk(from, "pal0", &palette);
+		}
+	}
+
+	//check that the streams agree on the vertex count, and that positions and palette indices are usable:
+	if (streams.empty()) {
+		throw std::runtime_error("no vertex data.");
+	}
+	for (Stream const &stream : streams) {
+		if (stream.data.size() % stream.stride != 0 || stream.data.size() / stream.stride != size()) {
+			throw std::runtime_error("vertex chunk '" + stream.magic + "' does not match the vertex count.");
+		}
+	}
+	Attribute const *position = find("Position");
+	if (!position || position->integer || position->count < 2) {
+		throw std::runtime_error("vertex data has no (usable) 'Position' attribute.");
+	}
+	if (Attribute const *color_index = find("ColorIndex")) {
+		bool is_unsigned = (color_index->type == UnsignedByte || color_index->type == UnsignedShort || color_index->type == UnsignedInt);
+		if (!color_index->integer || !is_unsigned || palette.empty() || palette.size() > 256) {
+			throw std::runtime_error("'ColorIndex' attribute needs unsigned integer indices and a palette of 1 to 256 colors.");
+		}
+		for (size_t v = 0; v < size(); ++v) {
+			if (get(*color_index, v).x >= float(palette.size())) {
+				throw std::runtime_error("color index outside palette.");
+			}
+		}
+	}
+}
+
+void MeshVertices::write(std::ostream &to, uint32_t flags) const {
+	if (layout == Colors) {
+		write_chunk(to, "dat0", streams.at(0).data, flags);
+	} else if (layout == Paletted) {
+		write_chunk(to, "dat1", streams.at(0).data, flags);
+		write_chunk(to, "pal0", palette, flags);
+		write_chunk(to, "cix0", streams.at(1).data, flags);
+	} else {
+		std::vector< AttributeEntry > entries;
+		for (Attribute const &attribute : attributes) {
+			AttributeEntry e;
+			std::memset(&e, 0, sizeof(e));
+			if (attribute.name.size() > sizeof(e.name)) {
+				throw std::runtime_error("vertex attribute name '" + attribute.name + "' is too long.");
+			}
+			std::memcpy(e.name, attribute.name.data(), attribute.name.size());
+			std::memcpy(e.chunk, streams[attribute.stream].magic.data(), 4);
+			e.type = attribute.type;
+			e.count = attribute.count;
+			e.normalized = attribute.normalized;
+			e.integer = attribute.integer;
+			e.offset = attribute.offset;
+			e.stride = streams[attribute.stream].stride;
+			entries.emplace_back(e);
+		}
+		write_chunk(to, "vsc0", entries, flags);
+		for (Stream const &stream : streams) {
+			write_chunk(to, stream.magic, stream.data, flags);
+		}
+		if (!palette.empty()) {
+			write_chunk(to, "pal0", palette, flags);
+		}
+	}
+}
+
+//IEEE half to float (normals and denormals; infinities and NaNs aren't expected in vertex data):
+static float half_to_float(uint16_t h) {
+	float sign = (h & 0x8000) ? -1.0f : 1.0f;
+	int32_t exponent = (h >> 10) & 0x1f;
+	float mantissa = float(h & 0x3ff);
+	if (exponent == 0) return sign * std::ldexp(mantissa, -24);
+	return sign * std::ldexp(1024.0f + mantissa, exponent - 25);
+}
+
+glm::vec4 MeshVertices::get(Attribute const &attribute, size_t vertex) const {
+	Stream const &stream = streams[attribute.stream];
+	uint8_t const *at = stream.data.data() + vertex * stream.stride + attribute.offset;
+	glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+	for (uint32_t c = 0; c < attribute.count; ++c, at += type_size(attribute.type)) {
+		bool n = attribute.normalized;
+		switch (attribute.type) {
+			case Byte: { int8_t v; std::memcpy(&v, at, 1); value[c] = n ? std::max(v / 127.0f, -1.0f) : float(v); } break;
+			case UnsignedByte: { uint8_t v = *at; value[c] = n ? v / 255.0f : float(v); } break;
+			case Short: { int16_t v; std::memcpy(&v, at, 2); value[c] = n ? std::max(v / 32767.0f, -1.0f) : float(v); } break;
+			case UnsignedShort: { uint16_t v; std::memcpy(&v, at, 2); value[c] = n ? v / 65535.0f : float(v); } break;
+			case Int: { int32_t v; std::memcpy(&v, at, 4); value[c] = n ? std::max(float(v / 2147483647.0), -1.0f) : float(v); } break;
+			case UnsignedInt: { uint32_t v; std::memcpy(&v, at, 4); value[c] = n ? float(v / 4294967295.0) : float(v); } break;
+			case Float: { std::memcpy(&value[c], at, 4); } break;
+			case HalfFloat: { uint16_t v; std::memcpy(&v, at, 2); value[c] = half_to_float(v); } break;
+		}
+	}
+	return value;
+}
+
+std::vector< MeshVertices::Vertex > MeshVertices::expanded() const {
+	Attribute const *position = find("Position");
+	Attribute const *normal = find("Normal");
+	Attribute const *color = find("Color");
+	Attribute const *color_index = find("ColorIndex");
+
+	std::vector< Vertex > out(size());
+	for (size_t v = 0; v < out.size(); ++v) {
+		out[v].Position = glm::vec3(get(*position, v));
+		out[v].Normal = (normal ? glm::vec3(get(*normal, v)) : glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::vec4 c = (color ? get(*color, v) : glm::vec4(1.0f));
+		if (color_index) {
+			c = c * (glm::vec4(palette[uint32_t(get(*color_index, v).x)]) / 255.0f);
+		}
+		out[v].Color = glm::u8vec4(glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+	return out;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//MeshVertices holds the vertex data at the start of meshes.blob (see meshes/export-meshes.py)
+// as a list of attributes stored in one or more chunks ("streams"). It is stored either with a
+// schema describing the attributes:
+//  "vsc0" chunk: AttributeEntry per attribute
+//  one chunk per stream named by the attributes (in order of first mention): per-vertex data
+//  "pal0" chunk (optional): glm::u8vec4 per palette color (at most 256), for a 'ColorIndex' attribute (of an unsigned integer type)
+//or in one of two older, fixed layouts:
+//  "dat0" chunk: (vec3 Position, vec3 Normal, u8vec4 Color) per vertex
+//or
+//  "dat1" chunk: (vec3 Position, vec3 Normal) per vertex
+//  "pal0" chunk: glm::u8vec4 per palette color (at most 256)
+//  "cix0" chunk: uint8_t ColorIndex per vertex
+//Older layouts are read into the same attribute list, and written back the way they were read.
+struct MeshVertices {
+	//component types (same values as the OpenGL enums, so they can be handed straight to glVertexAttribPointer):
+	enum Type : uint32_t {
+		Byte = 0x1400,
+		UnsignedByte = 0x1401,
+		Short = 0x1402,
+		UnsignedShort = 0x1403,
+		Int = 0x1404,
+		UnsignedInt = 0x1405,
+		Float = 0x1406,
+		HalfFloat = 0x140B,
+	};
+	static uint32_t type_size(uint32_t type); //0 for unknown types
+
+	struct AttributeEntry {
+		char name[24]; //shader attribute name ('\0'-padded)
+		char chunk[4]; //magic number of the chunk holding the attribute
+		uint32_t type; //Type of each component
+		uint32_t count; //components (1-4)
+		uint32_t normalized; //1: integer types map to [0,1] (unsigned) or [-1,1] (signed); 0: converted as-is
+		uint32_t integer; //1: integer types stay integers (for 'int'/'uint' shader inputs)
+		uint32_t offset; //of the attribute within each vertex's data in the chunk
+		uint32_t stride; //bytes per vertex in the chunk (the same for every attribute in a chunk)
+	};
+	static_assert(sizeof(AttributeEntry) == 52, "AttributeEntry should be packed.");
+
+	struct Stream {
+		std::string magic;
+		uint32_t stride = 0;
+		std::vector< uint8_t > data;
+	};
+
+	struct Attribute {
+		std::string name;
+		uint32_t type = Float;
+		uint32_t count = 0;
+		bool normalized = false;
+		bool integer = false;
+		uint32_t stream = 0; //index into streams
+		uint32_t offset = 0;
+	};
+
+	std::vector< Attribute > attributes;
+	std::vector< Stream > streams;
+	std::vector< glm::u8vec4 > palette; //looked up by 'ColorIndex' (if any)
+
+	enum Layout {
+		Schema, //"vsc0" + streams
+		Colors, //"dat0"
+		Paletted, //"dat1" + "pal0" + "cix0"
+	} layout = Schema;
+
+	size_t size() const { return streams.empty() ? 0 : streams[0].data.size() / streams[0].stride; }
+	Attribute const *find(std::string const &name) const; //nullptr if missing
+
+	//read from the current position in 'from' (throws on malformed data):
+	void read(std::istream &from);
+	//write in the same layout it was read ('flags' as for write_chunk):
+	void write(std::ostream &to, uint32_t flags = 0) const;
+
+	//one attribute of one vertex, converted to float as OpenGL would (missing components as (0,0,0,1)):
+	glm::vec4 get(Attribute const &attribute, size_t vertex) const;
+
+	//position, normal, and color of every vertex, for code that doesn't use the schema (e.g., SoftRenderer):
+	// - colors are 'Color' times the palette color of 'ColorIndex' (either one defaults to white);
+	// - missing normals are (0,0,1).
+	struct Vertex {
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::u8vec4 Color;
+	};
+	static_assert(sizeof(Vertex) == 28, "Vertex should be packed.");
+	std::vector< Vertex > expanded() const;
+};
@@ -0,0 +1,23 @@
+#include "Mipmaps.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+void downsample(glm::uvec2 size, std::vector< glm::u8vec4 > const &pixels, std::vector< glm::u8vec4 > *out_) {
+	assert(out_ && pixels.size() == size.x * size.y);
+	auto &out = *out_;
+
+	glm::uvec2 half = mipmap_size(size);
+	out.resize(half.x * half.y);
+	for (uint32_t y = 0; y < half.y; ++y) {
+		glm::u8vec4 const *row0 = &pixels[(2 * y) * size.x];
+		glm::u8vec4 const *row1 = &pixels[std::min(2 * y + 1, size.y - 1) * size.x];
+		glm::u8vec4 *dst = &out[y * half.x];
+		for (uint32_t x = 0; x < half.x; ++x) {
+			uint32_t x0 = 2 * x;
+			uint32_t x1 = std::min(2 * x + 1, size.x - 1);
+			glm::uvec4 sum = glm::uvec4(row0[x0]) + glm::uvec4(row0[x1]) + glm::uvec4(row1[x0]) + glm::uvec4(row1[x1]);
+			dst[x] = glm::u8vec4((sum + glm::uvec4(2)) / glm::uvec4(4));
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+//CPU mipmap generation for RGBA8 images (used by TextureLoader at load time and by
+// texcompress offline).
+
+//size of the next level down (each dimension halved, but at least 1):
+inline glm::uvec2 mipmap_size(glm::uvec2 size) {
+	return glm::max(size / glm::uvec2(2), glm::uvec2(1));
+}
+
+//number of levels in a full chain for 'size' (down to 1x1):
+inline uint32_t mipmap_levels(glm::uvec2 size) {
+	uint32_t levels = 1;
+	while (size != glm::uvec2(1)) {
+		size = mipmap_size(size);
+		++levels;
+	}
+	return levels;
+}
+
+//fill 'out' with the next level down from 'pixels' (rows in either order) with a 2x2 box filter
+// (for odd sizes, the last source row / column is dropped; for 1-wide sources, it is repeated):
+void downsample(glm::uvec2 size, std::vector< glm::u8vec4 > const &pixels, std::vector< glm::u8vec4 > *out);
@@ -0,0 +1,307 @@
+#include "PagedBoard.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+
+#if defined(_WIN32)
+//no mmap; constructors throw.
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+constexpr char const PagedBoard::Magic[8];
+
+static_assert(sizeof(PagedBoard::Header) <= PagedBoard::PageBytes, "Header fits in the first page.");
+
+static inline size_t round_up(size_t value, size_t align) {
+	return (value + align - 1) / align * align;
+}
+
+static glm::uvec2 chunk_counts(glm::uvec2 board_size) {
+	glm::uvec2 chunks = (board_size + glm::uvec2(PagedBoard::ChunkSize - 1)) / glm::uvec2(PagedBoard::ChunkSize);
+	if (board_size.x == 0 || board_size.y == 0 || uint64_t(chunks.x) * chunks.y >= 0xffffffffULL) {
+		throw std::runtime_error("Paged board size " + std::to_string(board_size.x) + "x" + std::to_string(board_size.y) + " is out of range.");
+	}
+	return chunks;
+}
+
+//splitmix64 finalizer, for picking meshes from (seed, cell) without storing a generator state:
+static inline uint64_t mix64(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+static inline glm::quat load_rotation(float const *r) {
+	return glm::quat(r[3] + 1.0f, r[0], r[1], r[2]);
+}
+
+static inline void store_rotation(glm::quat const &q, float *r) {
+	r[0] = q.x;
+	r[1] = q.y;
+	r[2] = q.z;
+	r[3] = q.w - 1.0f;
+}
+
+glm::quat PagedBoard::rotation(uint32_t x, uint32_t y) {
+	return load_rotation(chunk_at(x, y)->rotations[local_index(x % ChunkSize, y % ChunkSize)]);
+}
+
+BoardSim::MeshId PagedBoard::mesh(uint32_t x, uint32_t y) {
+	return chunk_at(x, y)->meshes[local_index(x % ChunkSize, y % ChunkSize)];
+}
+
+PagedBoard::Chunk *PagedBoard::chunk_at(uint32_t x, uint32_t y) {
+	uint32_t index = (y / ChunkSize) * chunks.x + (x / ChunkSize);
+	if (index == last_index) {
+		stats.hits += 1;
+		return last_chunk;
+	}
+
+	auto f = resident.find(index);
+	if (f != resident.end()) {
+		stats.hits += 1;
+		lru.splice(lru.begin(), lru, f->second.lru_entry);
+		last_chunk = f->second.chunk;
+	} else {
+		stats.misses += 1;
+		if (resident.size() >= max_resident) {
+			uint32_t victim = lru.back();
+			lru.pop_back();
+			auto v = resident.find(victim);
+#if !defined(_WIN32)
+			munmap(v->second.chunk, chunk_bytes);
+#endif
+			resident.erase(v);
+			stats.evictions += 1;
+		}
+		lru.emplace_front(index);
+		Resident &r = resident[index];
+		r.chunk = map_chunk(index);
+		r.lru_entry = lru.begin();
+		last_chunk = r.chunk;
+	}
+	last_index = index;
+	return last_chunk;
+}
+
+void PagedBoard::roll_cross(glm::uvec2 cursor, glm::quat const &dr) {
+	//row, one chunk at a time:
+	uint32_t ly = cursor.y % ChunkSize;
+	for (uint32_t x0 = 0; x0 < board_size.x; x0 += ChunkSize) {
+		Chunk *chunk = chunk_at(x0, cursor.y);
+		uint32_t x1 = std::min(x0 + ChunkSize, board_size.x);
+		for (uint32_t x = x0; x < x1; ++x) {
+			float *r = chunk->rotations[local_index(x - x0, ly)];
+			store_rotation(glm::normalize(dr * load_rotation(r)), r);
+		}
+	}
+	//column (skipping the cursor's cell, which the row already rolled):
+	uint32_t lx = cursor.x % ChunkSize;
+	for (uint32_t y0 = 0; y0 < board_size.y; y0 += ChunkSize) {
+		Chunk *chunk = chunk_at(cursor.x, y0);
+		uint32_t y1 = std::min(y0 + ChunkSize, board_size.y);
+		for (uint32_t y = y0; y < y1; ++y) {
+			if (y == cursor.y) continue;
+			float *r = chunk->rotations[local_index(lx, y - y0)];
+			store_rotation(glm::normalize(dr * load_rotation(r)), r);
+		}
+	}
+}
+
+void PagedBoard::read_window(glm::uvec2 origin, glm::uvec2 size, BoardSim *sim) {
+	origin = glm::min(origin, board_size - glm::uvec2(1));
+	size = glm::min(size, board_size - origin);
+
+	sim->board_size = size;
+	sim->discrete = false;
+	sim->sparse = false;
+	sim->cursor = glm::min(sim->cursor, size - glm::uvec2(1));
+	sim->board_meshes.resize(size.x * size.y);
+	sim->board_rotations.resize(size.x * size.y);
+
+	//visit the window chunk by chunk, so each chunk is looked up once:
+	for (uint32_t y0 = origin.y; y0 < origin.y + size.y; y0 = (y0 / ChunkSize + 1) * ChunkSize) {
+		uint32_t y1 = std::min((y0 / ChunkSize + 1) * ChunkSize, origin.y + size.y);
+		for (uint32_t x0 = origin.x; x0 < origin.x + size.x; x0 = (x0 / ChunkSize + 1) * ChunkSize) {
+			uint32_t x1 = std::min((x0 / ChunkSize + 1) * ChunkSize, origin.x + size.x);
+			Chunk const *chunk = chunk_at(x0, y0);
+			for (uint32_t y = y0; y < y1; ++y) {
+				for (uint32_t x = x0; x < x1; ++x) {
+					uint32_t local = local_index(x % ChunkSize, y % ChunkSize);
+					uint32_t i = (y - origin.y) * size.x + (x - origin.x);
+					sim->board_meshes[i] = chunk->meshes[local];
+					sim->board_rotations[i] = load_rotation(chunk->rotations[local]);
+				}
+			}
+		}
+	}
+	sim->state_hash = sim->compute_hash();
+}
+
+void PagedBoard::prefetch(glm::uvec2 cursor, glm::uvec2 view_origin, glm::uvec2 view_size) {
+	std::vector< uint32_t > wanted;
+	auto want = [&](uint32_t cx, uint32_t cy) {
+		uint32_t index = cy * chunks.x + cx;
+		if (resident.count(index) == 0) wanted.emplace_back(index);
+	};
+
+	//view, plus a one-chunk margin (where the camera is likely to move next):
+	glm::uvec2 lo = view_origin / glm::uvec2(ChunkSize);
+	glm::uvec2 hi = (view_origin + view_size + glm::uvec2(ChunkSize - 1)) / glm::uvec2(ChunkSize);
+	lo = glm::uvec2(lo.x > 0 ? lo.x - 1 : 0, lo.y > 0 ? lo.y - 1 : 0);
+	hi = glm::min(hi + glm::uvec2(1), chunks);
+	for (uint32_t cy = lo.y; cy < hi.y; ++cy) {
+		for (uint32_t cx = lo.x; cx < hi.x; ++cx) {
+			want(cx, cy);
+		}
+	}
+
+	//cursor's row and column (what the next roll touches), nearest the cursor first:
+	glm::uvec2 c = glm::min(cursor, board_size - glm::uvec2(1)) / glm::uvec2(ChunkSize);
+	uint32_t reach = std::max(chunks.x, chunks.y);
+	for (uint32_t d = 0; d < reach; ++d) {
+		if (c.x + d < chunks.x) want(c.x + d, c.y);
+		if (d > 0 && d <= c.x) want(c.x - d, c.y);
+		if (d > 0 && c.y + d < chunks.y) want(c.x, c.y + d);
+		if (d > 0 && d <= c.y) want(c.x, c.y - d);
+	}
+
+	{
+		std::unique_lock< std::mutex > lock(queue_mutex);
+		queue.assign(wanted.begin(), wanted.end());
+	}
+	queue_cv.notify_one();
+}
+
+#if defined(_WIN32)
+
+void PagedBoard::create(std::string const &, glm::uvec2, uint32_t) {
+	throw std::runtime_error("Paged boards are not supported on this platform.");
+}
+PagedBoard::PagedBoard(std::string const &, uint32_t) {
+	throw std::runtime_error("Paged boards are not supported on this platform.");
+}
+PagedBoard::~PagedBoard() { }
+PagedBoard::Chunk *PagedBoard::map_chunk(uint32_t) { return nullptr; }
+void PagedBoard::prefetch_loop() { }
+
+#else
+
+void PagedBoard::create(std::string const &path, glm::uvec2 board_size, uint32_t seed) {
+	glm::uvec2 chunks = chunk_counts(board_size);
+
+	Header header;
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.board_size_x = board_size.x;
+	header.board_size_y = board_size.y;
+	header.seed = seed;
+	header.chunk_size = ChunkSize;
+	header.chunk_bytes = round_up(sizeof(Chunk), PageBytes);
+
+	int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to create '" + path + "': " + std::strerror(errno));
+	}
+	//chunks are left as holes (zeros), which read as identity rotations and uninitialized meshes:
+	off_t bytes = off_t(PageBytes + uint64_t(chunks.x) * chunks.y * header.chunk_bytes);
+	if (ftruncate(fd, bytes) != 0 || pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))) {
+		int err = errno;
+		close(fd);
+		throw std::runtime_error("Failed to write '" + path + "': " + std::strerror(err));
+	}
+	close(fd);
+}
+
+PagedBoard::PagedBoard(std::string const &path, uint32_t max_resident_) : max_resident(std::max(1U, max_resident_)) {
+	fd = open(path.c_str(), O_RDWR);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open '" + path + "': " + std::strerror(errno));
+	}
+	Header header;
+	if (pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header))
+	 || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0
+	 || header.chunk_size != ChunkSize
+	 || header.chunk_bytes != round_up(sizeof(Chunk), PageBytes)) {
+		close(fd);
+		throw std::runtime_error("'" + path + "' is not a paged board (or has a different chunk layout).");
+	}
+	board_size = glm::uvec2(header.board_size_x, header.board_size_y);
+	chunks = chunk_counts(board_size);
+	seed = header.seed;
+	chunk_bytes = header.chunk_bytes;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || uint64_t(st.st_size) < PageBytes + uint64_t(chunks.x) * chunks.y * chunk_bytes) {
+		close(fd);
+		throw std::runtime_error("'" + path + "' is truncated.");
+	}
+
+	prefetcher = std::thread(&PagedBoard::prefetch_loop, this);
+}
+
+PagedBoard::~PagedBoard() {
+	{
+		std::unique_lock< std::mutex > lock(queue_mutex);
+		quit = true;
+	}
+	queue_cv.notify_one();
+	if (prefetcher.joinable()) prefetcher.join();
+
+	for (auto const &r : resident) {
+		munmap(r.second.chunk, chunk_bytes);
+	}
+	if (fd >= 0) close(fd);
+}
+
+PagedBoard::Chunk *PagedBoard::map_chunk(uint32_t index) {
+	off_t offset = off_t(PageBytes + uint64_t(index) * chunk_bytes);
+	void *mapping = mmap(nullptr, chunk_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+	if (mapping == MAP_FAILED) {
+		throw std::runtime_error(std::string("Failed to map board chunk: ") + std::strerror(errno));
+	}
+	Chunk *chunk = reinterpret_cast< Chunk * >(mapping);
+
+	if (!chunk->initialized) {
+		//first use of this chunk: pick meshes (rotations are already identity):
+		uint32_t cx = index % chunks.x, cy = index / chunks.x;
+		for (uint32_t ly = 0; ly < ChunkSize; ++ly) {
+			for (uint32_t lx = 0; lx < ChunkSize; ++lx) {
+				uint64_t cell = uint64_t(cy * ChunkSize + ly) * board_size.x + (cx * ChunkSize + lx);
+				chunk->meshes[local_index(lx, ly)] = BoardSim::MeshId(mix64(cell ^ (uint64_t(seed) << 40)) % BoardSim::MeshIdCount);
+			}
+		}
+		chunk->initialized = 1;
+	}
+	return chunk;
+}
+
+void PagedBoard::prefetch_loop() {
+	//reading a chunk pulls it into the OS page cache, so mapping it later is only soft page faults:
+	std::vector< char > scratch(chunk_bytes);
+	while (true) {
+		uint32_t index;
+		{
+			std::unique_lock< std::mutex > lock(queue_mutex);
+			queue_cv.wait(lock, [this](){ return quit || !queue.empty(); });
+			if (quit) return;
+			index = queue.front();
+			queue.pop_front();
+		}
+		off_t offset = off_t(PageBytes + uint64_t(index) * chunk_bytes);
+		if (pread(fd, scratch.data(), chunk_bytes, offset) == ssize_t(chunk_bytes)) {
+			stats.prefetched += 1;
+		}
+	}
+}
+
+#endif
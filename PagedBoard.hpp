@@ -0,0 +1,126 @@
+#pragma once
+
+#include "BoardSim.hpp"
+#include "morton.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <list>
+#include <string>
+#include <cstdint>
+
+//PagedBoard is a continuous-mode board stored in a memory-mapped file, for boards larger than RAM
+// (e.g., 65536x65536 cells, ~75GB on disk).
+//
+//The board is split into ChunkSize x ChunkSize chunks, each a page-aligned block of the file holding
+// rotations and meshes in Z-order (so nearby cells share pages whichever way they are walked).
+//Only up to 'max_resident' chunks are mapped at once; the least recently used one is unmapped
+// (and written back by the OS) to make room. A background thread reads chunks that will soon be
+// needed -- near the camera and along the cursor's row and column -- into the OS page cache, so
+// mapping them later doesn't wait on the disk.
+//
+//Rotations are stored as (x, y, z, w-1), so never-written parts of the (sparse) file read as
+// identity; meshes are filled in from the seed the first time a chunk is mapped.
+//
+//All methods except the prefetch thread's work are meant to be called from one thread.
+struct PagedBoard {
+	enum : uint32_t {
+		ChunkSize = 64,
+		ChunkCells = ChunkSize * ChunkSize,
+	};
+
+	//file layout: [Header, padded to PageBytes][Chunk 0][Chunk 1]... (chunks row-major by chunk)
+	struct Header {
+		char magic[8] = {'\0','\0','\0','\0','\0','\0','\0','\0'};
+		uint32_t board_size_x = 0;
+		uint32_t board_size_y = 0;
+		uint32_t seed = 0;
+		uint32_t chunk_size = 0;
+		uint64_t chunk_bytes = 0;
+	};
+
+	constexpr static char const Magic[8] = {'p','a','g','e','d','b','d','0'};
+	enum : uint32_t { PageBytes = 4096 };
+
+	struct Chunk {
+		float rotations[ChunkCells][4]; //(x, y, z, w-1), by Z-order index within the chunk
+		BoardSim::MeshId meshes[ChunkCells]; //by Z-order index within the chunk
+		uint32_t initialized; //0 until meshes have been filled in
+	};
+
+	//create (or replace) a board file; no chunk data is written, so this is fast for any size:
+	static void create(std::string const &path, glm::uvec2 board_size, uint32_t seed);
+
+	//open an existing board file, keeping at most 'max_resident' chunks mapped:
+	PagedBoard(std::string const &path, uint32_t max_resident);
+	~PagedBoard();
+	PagedBoard(PagedBoard const &) = delete;
+	PagedBoard &operator=(PagedBoard const &) = delete;
+
+	//rotate every cell on the same row or column as 'cursor' by 'dr' (as BoardSim::roll_cross):
+	void roll_cross(glm::uvec2 cursor, glm::quat const &dr);
+
+	//copy the cells in [origin, origin+size) into 'sim' (as a dense continuous board), for drawing:
+	void read_window(glm::uvec2 origin, glm::uvec2 size, BoardSim *sim);
+
+	//queue chunks for background reading: those in (and one chunk around) the view, then those on
+	// the cursor's row and column, nearest first. Replaces any requests not yet started:
+	void prefetch(glm::uvec2 cursor, glm::uvec2 view_origin, glm::uvec2 view_size);
+
+	glm::quat rotation(uint32_t x, uint32_t y);
+	BoardSim::MeshId mesh(uint32_t x, uint32_t y);
+
+	//the chunk containing cell (x,y), mapping it if needed; stays valid until the next call:
+	Chunk *chunk_at(uint32_t x, uint32_t y);
+
+	//index of cell (lx,ly) within a chunk, interleaving the bits of lx and ly:
+	static uint32_t local_index(uint32_t lx, uint32_t ly) {
+		return morton_index(lx, ly);
+	}
+
+	glm::uvec2 board_size = glm::uvec2(0,0);
+	glm::uvec2 chunks = glm::uvec2(0,0); //board size in chunks
+	uint32_t seed = 0;
+	size_t chunk_bytes = 0;
+
+	struct {
+		uint64_t hits = 0; //chunk_at() found the chunk mapped
+		uint64_t misses = 0; //chunk_at() had to map the chunk
+		uint64_t evictions = 0; //chunks unmapped to make room
+		std::atomic< uint64_t > prefetched{0}; //chunks read by the prefetch thread
+	} stats;
+
+	size_t resident_bytes() const { return resident.size() * chunk_bytes; }
+
+	//------- internals -------
+
+	int fd = -1;
+	uint32_t max_resident = 0;
+
+	//mapped chunks, most recently used at the front of 'lru':
+	struct Resident {
+		Chunk *chunk = nullptr;
+		std::list< uint32_t >::iterator lru_entry;
+	};
+	std::unordered_map< uint32_t, Resident > resident;
+	std::list< uint32_t > lru;
+	uint32_t last_index = -1U; //most recent chunk_at() result, to skip the lookup for runs in one chunk
+	Chunk *last_chunk = nullptr;
+
+	Chunk *map_chunk(uint32_t index);
+
+	//prefetch thread and its request queue:
+	std::thread prefetcher;
+	std::mutex queue_mutex;
+	std::condition_variable queue_cv;
+	std::deque< uint32_t > queue;
+	bool quit = false;
+	void prefetch_loop();
+};
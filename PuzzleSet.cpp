@@ -0,0 +1,92 @@
+#include "PuzzleSet.hpp"
+
+#include "CubeRotations.hpp"
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+static_assert((1U << PuzzleSet::BitsPerCell) >= CubeRotations::Count, "packed cells hold any orientation");
+
+static uint32_t packed_stride(glm::uvec2 board_size) {
+	return (board_size.x * board_size.y * PuzzleSet::BitsPerCell + 7) / 8;
+}
+
+PuzzleSet::PuzzleSet(glm::uvec2 board_size_) : board_size(board_size_), stride(packed_stride(board_size_)) {
+}
+
+void PuzzleSet::add(Info const &info, std::vector< uint8_t > const &orientations) {
+	if (orientations.size() != board_size.x * board_size.y) {
+		throw std::runtime_error("Puzzle does not match puzzle set board size.");
+	}
+	infos.emplace_back(info);
+	size_t base = packed.size();
+	packed.resize(base + stride, 0);
+	uint8_t *out = packed.data() + base;
+	for (uint32_t i = 0; i < orientations.size(); ++i) {
+		uint32_t bit = i * BitsPerCell;
+		uint32_t value = uint32_t(orientations[i]) << (bit % 8);
+		//a cell spans at most two bytes:
+		out[bit / 8] |= uint8_t(value);
+		if ((bit % 8) + BitsPerCell > 8) out[bit / 8 + 1] |= uint8_t(value >> 8);
+	}
+}
+
+void PuzzleSet::unpack(uint32_t index, std::vector< uint8_t > *orientations) const {
+	if (index >= infos.size()) {
+		throw std::runtime_error("Puzzle index " + std::to_string(index) + " out of range (set has " + std::to_string(infos.size()) + " puzzles).");
+	}
+	uint8_t const *in = packed.data() + size_t(index) * stride;
+	orientations->resize(board_size.x * board_size.y);
+	for (uint32_t i = 0; i < orientations->size(); ++i) {
+		uint32_t bit = i * BitsPerCell;
+		uint32_t value = in[bit / 8];
+		if ((bit % 8) + BitsPerCell > 8) value |= uint32_t(in[bit / 8 + 1]) << 8;
+		uint8_t o = uint8_t((value >> (bit % 8)) & ((1U << BitsPerCell) - 1));
+		if (o >= CubeRotations::Count) {
+			throw std::runtime_error("Puzzle " + std::to_string(index) + " has an invalid orientation.");
+		}
+		(*orientations)[i] = o;
+	}
+}
+
+void PuzzleSet::load(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open puzzle set '" + filename + "'.");
+	}
+
+	std::vector< Header > header;
+	read_chunk(file, "pzs0", &header);
+	if (header.size() != 1) {
+		throw std::runtime_error("Puzzle set '" + filename + "' should have exactly one header.");
+	}
+	board_size = glm::uvec2(header[0].board_size_x, header[0].board_size_y);
+	stride = packed_stride(board_size);
+	if (header[0].stride != stride) {
+		throw std::runtime_error("Puzzle set '" + filename + "' has an unexpected stride.");
+	}
+
+	read_chunk(file, "pzi0", &infos);
+	read_chunk(file, "pzb0", &packed);
+	if (infos.size() != header[0].count || packed.size() != size_t(header[0].count) * stride) {
+		throw std::runtime_error("Puzzle set '" + filename + "' has mismatched puzzle counts.");
+	}
+}
+
+void PuzzleSet::save(std::string const &filename) const {
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open puzzle set '" + filename + "' for writing.");
+	}
+
+	std::vector< Header > header(1);
+	header[0].board_size_x = board_size.x;
+	header[0].board_size_y = board_size.y;
+	header[0].count = uint32_t(infos.size());
+	header[0].stride = stride;
+	write_chunk(file, "pzs0", header);
+	write_chunk(file, "pzi0", infos);
+	write_chunk(file, "pzb0", packed);
+}
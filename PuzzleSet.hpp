@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//A PuzzleSet is a list of discrete-mode starting boards (all the same size), each with
+// the seed for its meshes (as in BoardSim::reset) and a difficulty rating from the Solver.
+//The goal for every puzzle is the board with all cells at CubeRotations::Identity.
+//
+//Orientations are bit-packed, 5 bits per cell, and every puzzle takes the same number
+// of bytes, so any puzzle can be unpacked by index without touching the others.
+//
+//File format (see read_chunk.hpp):
+//  "pzs0" chunk: one Header
+//  "pzi0" chunk: Info per puzzle
+//  "pzb0" chunk: uint8_t packed orientations, Header::stride bytes per puzzle
+struct PuzzleSet {
+	struct Header {
+		uint32_t board_size_x = 0;
+		uint32_t board_size_y = 0;
+		uint32_t count = 0;
+		uint32_t stride = 0; //bytes per packed board
+	};
+	static_assert(sizeof(Header) == 16, "PuzzleSet::Header should be packed.");
+
+	struct Info {
+		uint32_t seed = 0; //mesh seed for BoardSim::reset
+		uint32_t nodes = 0; //positions the solver expanded (secondary difficulty measure)
+		uint8_t moves = 0; //length of shortest solution (or lower bound, if LowerBound is set)
+		uint8_t flags = 0;
+		uint16_t reserved = 0;
+	};
+	static_assert(sizeof(Info) == 12, "PuzzleSet::Info should be packed.");
+	enum : uint8_t {
+		LowerBound = 1, //solver gave up; 'moves' is a lower bound
+	};
+
+	enum : uint32_t {
+		BitsPerCell = 5, //enough for CubeRotations::Count
+	};
+
+	PuzzleSet() = default;
+	explicit PuzzleSet(glm::uvec2 board_size);
+
+	glm::uvec2 board_size = glm::uvec2(0,0);
+	uint32_t stride = 0; //bytes per packed board
+	std::vector< Info > infos;
+	std::vector< uint8_t > packed; //infos.size() * stride bytes
+
+	uint32_t size() const { return uint32_t(infos.size()); }
+
+	//append a puzzle ('orientations' has board_size.x * board_size.y CubeRotations indices):
+	void add(Info const &info, std::vector< uint8_t > const &orientations);
+
+	//unpack the orientations of puzzle 'index':
+	void unpack(uint32_t index, std::vector< uint8_t > *orientations) const;
+
+	//throw on failure:
+	void load(std::string const &filename);
+	void save(std::string const &filename) const;
+};
@@ -0,0 +1,45 @@
+#include "Replay.hpp"
+
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+void Replay::load(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open replay '" + filename + "'.");
+	}
+
+	std::vector< Header > header;
+	read_chunk(file, "rpl0", &header);
+	if (header.size() != 1) {
+		throw std::runtime_error("Replay '" + filename + "' should have exactly one header.");
+	}
+	board_size = glm::uvec2(header[0].board_size_x, header[0].board_size_y);
+	seed = header[0].seed;
+	discrete = (header[0].flags & Discrete) != 0;
+
+	read_chunk(file, "inp0", &inputs);
+	read_chunk(file, "hsh0", &hashes);
+	if (hashes.size() != inputs.size()) {
+		throw std::runtime_error("Replay '" + filename + "' has mismatched input and hash counts.");
+	}
+}
+
+void Replay::save(std::string const &filename) const {
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open replay '" + filename + "' for writing.");
+	}
+
+	std::vector< Header > header(1);
+	header[0].board_size_x = board_size.x;
+	header[0].board_size_y = board_size.y;
+	header[0].seed = seed;
+	header[0].flags = (discrete ? Discrete : 0);
+	write_chunk(file, "rpl0", header);
+	write_chunk(file, "inp0", inputs);
+	write_chunk(file, "hsh0", hashes);
+}
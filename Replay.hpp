@@ -0,0 +1,41 @@
+#pragma once
+
+#include "BoardSim.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//A Replay records a play session: the starting board (size and seed for BoardSim::reset),
+// the input for every tick, and the board hash after every tick.
+//Replaying the inputs through another implementation (e.g., 'server --replay') and comparing
+// hashes tick-by-tick finds the first tick where it diverges from the recording.
+//
+//File format (see read_chunk.hpp):
+//  "rpl0" chunk: one Header
+//  "inp0" chunk: BoardSim::TickInput per tick
+//  "hsh0" chunk: uint64_t board hash (BoardSim::state_hash) after each tick
+struct Replay {
+	struct Header {
+		uint32_t board_size_x = 0;
+		uint32_t board_size_y = 0;
+		uint32_t seed = 0;
+		uint32_t flags = 0; //Discrete if recorded in discrete mode
+	};
+	enum : uint32_t {
+		Discrete = 1,
+	};
+	static_assert(sizeof(Header) == 16, "Replay::Header should be packed.");
+
+	glm::uvec2 board_size = glm::uvec2(0,0);
+	uint32_t seed = 0;
+	bool discrete = false;
+	std::vector< BoardSim::TickInput > inputs;
+	std::vector< uint64_t > hashes; //hashes[i] is the board hash after inputs[i]
+
+	//throw on failure:
+	void load(std::string const &filename);
+	void save(std::string const &filename) const;
+};
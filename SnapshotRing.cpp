@@ -0,0 +1,228 @@
+#include "SnapshotRing.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <new>
+
+#if defined(_WIN32)
+//no POSIX shared memory; constructors throw.
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace SnapshotRing {
+
+static inline size_t round_up(size_t value, size_t align) {
+	return (value + align - 1) / align * align;
+}
+
+//POSIX shared memory object names must start with a slash:
+static std::string shm_name(std::string const &name) {
+	return (name.size() && name[0] == '/' ? name : "/" + name);
+}
+
+//byte offsets of the parts of a slot:
+static size_t meshes_offset() {
+	return round_up(sizeof(SlotHeader), 8);
+}
+static size_t rotations_offset(uint32_t max_cells) {
+	return round_up(meshes_offset() + max_cells * sizeof(BoardSim::MeshId), 8);
+}
+static size_t slot_bytes(uint32_t max_cells) {
+	return round_up(rotations_offset(max_cells) + max_cells * sizeof(BoardSim::QuantizedRotation), 64);
+}
+static size_t slots_offset() {
+	return round_up(sizeof(Header), 64);
+}
+
+static SlotHeader *slot_at(void *mapping, Header const &header, uint32_t index) {
+	return reinterpret_cast< SlotHeader * >(reinterpret_cast< char * >(mapping) + slots_offset() + index * header.slot_bytes);
+}
+
+#if defined(_WIN32)
+
+Writer::Writer(std::string const &, uint32_t, uint32_t) {
+	throw std::runtime_error("Shared memory snapshots are not supported on this platform.");
+}
+Writer::~Writer() { }
+void Writer::publish(glm::uvec2, glm::uvec2, BoardSim::MeshId const *, glm::quat const *, uint64_t) { }
+
+Reader::Reader(std::string const &) {
+	throw std::runtime_error("Shared memory snapshots are not supported on this platform.");
+}
+Reader::~Reader() { }
+bool Reader::read_latest(BoardSim *, uint64_t *) { return false; }
+
+#else
+
+Writer::Writer(std::string const &name_, uint32_t max_cells, uint32_t slot_count) : name(shm_name(name_)) {
+	if (slot_count < 2) {
+		throw std::runtime_error("Snapshot ring needs at least two slots.");
+	}
+	bytes = slots_offset() + slot_count * slot_bytes(max_cells);
+
+	//replace any stale object with the same name:
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to create shared memory '" + name + "': " + std::strerror(errno));
+	}
+	if (ftruncate(fd, off_t(bytes)) != 0) {
+		close(fd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Failed to size shared memory '" + name + "': " + std::strerror(errno));
+	}
+	mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Failed to map shared memory '" + name + "': " + std::strerror(errno));
+	}
+
+	//new shared memory is zero-filled; construct header and slot headers in place:
+	header = new (mapping) Header();
+	header->slot_count = slot_count;
+	header->max_cells = max_cells;
+	header->slot_bytes = slot_bytes(max_cells);
+	header->published.store(0);
+	for (uint32_t i = 0; i < slot_count; ++i) {
+		SlotHeader *slot = new (slot_at(mapping, *header, i)) SlotHeader();
+		slot->sequence.store(0);
+	}
+	//readers check the magic number before trusting anything else:
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header->magic, Magic, sizeof(Magic));
+}
+
+Writer::~Writer() {
+	if (mapping) {
+		munmap(mapping, bytes);
+		shm_unlink(name.c_str());
+	}
+}
+
+void Writer::publish(glm::uvec2 board_size, glm::uvec2 cursor,
+	BoardSim::MeshId const *meshes, glm::quat const *rotations, uint64_t tick) {
+	uint32_t cells = board_size.x * board_size.y;
+	if (cells > header->max_cells) {
+		throw std::runtime_error("Board too large for snapshot ring.");
+	}
+
+	uint64_t published = header->published.load(std::memory_order_relaxed);
+	SlotHeader *slot = slot_at(mapping, *header, uint32_t(published % header->slot_count));
+
+	//seqlock write: odd sequence while writing:
+	uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot->board_size_x = board_size.x;
+	slot->board_size_y = board_size.y;
+	slot->cursor_x = cursor.x;
+	slot->cursor_y = cursor.y;
+	slot->tick = tick;
+	char *base = reinterpret_cast< char * >(slot);
+	std::memcpy(base + meshes_offset(), meshes, cells * sizeof(BoardSim::MeshId));
+	BoardSim::QuantizedRotation *out = reinterpret_cast< BoardSim::QuantizedRotation * >(base + rotations_offset(header->max_cells));
+	for (uint32_t i = 0; i < cells; ++i) {
+		out[i] = BoardSim::quantize_rotation(rotations[i]);
+	}
+
+	slot->sequence.store(sequence + 2, std::memory_order_release);
+	header->published.store(published + 1, std::memory_order_release);
+}
+
+Reader::Reader(std::string const &name_) : name(shm_name(name_)) {
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open shared memory '" + name + "': " + std::strerror(errno));
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to stat shared memory '" + name + "'.");
+	}
+	bytes = size_t(info.st_size);
+	if (bytes < slots_offset()) {
+		close(fd);
+		throw std::runtime_error("Shared memory '" + name + "' is too small to be a snapshot ring.");
+	}
+	mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		throw std::runtime_error("Failed to map shared memory '" + name + "': " + std::strerror(errno));
+	}
+	header = reinterpret_cast< Header const * >(mapping);
+	if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0) {
+		munmap(mapping, bytes);
+		mapping = nullptr;
+		throw std::runtime_error("Shared memory '" + name + "' is not a (ready) snapshot ring.");
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slots_offset() + header->slot_count * header->slot_bytes > bytes) {
+		munmap(mapping, bytes);
+		mapping = nullptr;
+		throw std::runtime_error("Shared memory '" + name + "' has an inconsistent size.");
+	}
+}
+
+Reader::~Reader() {
+	if (mapping) {
+		munmap(mapping, bytes);
+	}
+}
+
+bool Reader::read_latest(BoardSim *sim, uint64_t *tick) {
+	while (true) {
+		uint64_t published = header->published.load(std::memory_order_acquire);
+		if (published == 0 || published == last_read) return false;
+
+		SlotHeader const *slot = slot_at(mapping, *header, uint32_t((published - 1) % header->slot_count));
+		uint32_t before = slot->sequence.load(std::memory_order_acquire);
+		if (before & 1) continue; //writer lapped us and is rewriting this slot
+
+		glm::uvec2 board_size(slot->board_size_x, slot->board_size_y);
+		uint32_t cells = board_size.x * board_size.y;
+		if (cells == 0 || cells > header->max_cells) continue; //torn header; sequence check would fail anyway
+
+		//snapshots are dense continuous boards; switch 'sim' to that storage (sized to match) if needed,
+		// so nothing is left sized for a different board (e.g., board_orientations, used by compute_hash):
+		if (sim->discrete || sim->sparse || sim->board_size != board_size) {
+			sim->reset(board_size, sim->seed);
+		}
+		sim->cursor = glm::uvec2(slot->cursor_x, slot->cursor_y);
+		uint64_t slot_tick = slot->tick;
+		sim->board_meshes.resize(cells);
+		sim->board_rotations.resize(cells);
+		char const *base = reinterpret_cast< char const * >(slot);
+		std::memcpy(sim->board_meshes.data(), base + meshes_offset(), cells * sizeof(BoardSim::MeshId));
+		BoardSim::QuantizedRotation const *in = reinterpret_cast< BoardSim::QuantizedRotation const * >(base + rotations_offset(header->max_cells));
+		for (uint32_t i = 0; i < cells; ++i) {
+			sim->board_rotations[i] = BoardSim::dequantize_rotation(in[i]);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint32_t after = slot->sequence.load(std::memory_order_relaxed);
+		if (after != before) continue; //slot was rewritten while copying; try again
+
+		//clamp in case the viewer's copy is used for drawing the cursor:
+		sim->cursor = glm::min(sim->cursor, board_size - glm::uvec2(1));
+		for (auto &mesh : sim->board_meshes) {
+			if (mesh >= BoardSim::MeshIdCount) mesh = BoardSim::Doll;
+		}
+		sim->state_hash = sim->compute_hash();
+		last_read = published;
+		if (tick) *tick = slot_tick;
+		return true;
+	}
+}
+
+#endif
+
+} //namespace SnapshotRing
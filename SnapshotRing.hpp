@@ -0,0 +1,79 @@
+#pragma once
+
+#include "BoardSim.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+//SnapshotRing is a ring of board snapshots in POSIX shared memory,
+// written by a simulation (e.g., 'server --publish NAME') and read by
+// a viewer (e.g., 'main --view NAME') running as a separate process.
+//
+//Each slot is guarded by a seqlock: the writer makes the slot's sequence
+// number odd while writing and even when done; readers retry if the sequence
+// number was odd or changed while they copied the slot out.
+//The writer fills slots in place (quantizing straight into shared memory),
+// so publishing makes no intermediate copies.
+
+namespace SnapshotRing {
+	//shared memory layout: [Header][Slot 0][Slot 1]...
+	// where each slot is [SlotHeader][MeshId x max_cells][QuantizedRotation x max_cells]
+	struct Header {
+		char magic[8] = {'\0','\0','\0','\0','\0','\0','\0','\0'}; //written last, once the header is initialized
+		uint32_t slot_count = 0;
+		uint32_t max_cells = 0;
+		uint64_t slot_bytes = 0;
+		std::atomic< uint64_t > published; //number of snapshots published; latest is in slot (published-1) % slot_count
+	};
+
+	constexpr char const Magic[8] = {'b','r','d','r','i','n','g','1'};
+
+	struct SlotHeader {
+		std::atomic< uint32_t > sequence; //odd while being written
+		uint32_t board_size_x = 0;
+		uint32_t board_size_y = 0;
+		uint32_t cursor_x = 0;
+		uint32_t cursor_y = 0;
+		uint32_t padding = 0;
+		uint64_t tick = 0;
+	};
+
+	//Writer creates (or replaces) the shared memory object and removes it when destroyed:
+	struct Writer {
+		Writer(std::string const &name, uint32_t max_cells, uint32_t slot_count = 4);
+		~Writer();
+		Writer(Writer const &) = delete;
+		Writer &operator=(Writer const &) = delete;
+
+		//publish a board, quantizing rotations directly into the next free slot:
+		void publish(glm::uvec2 board_size, glm::uvec2 cursor,
+			BoardSim::MeshId const *meshes, glm::quat const *rotations, uint64_t tick);
+
+		std::string name;
+		size_t bytes = 0;
+		void *mapping = nullptr;
+		Header *header = nullptr;
+	};
+
+	//Reader attaches to an existing shared memory object:
+	struct Reader {
+		Reader(std::string const &name);
+		~Reader();
+		Reader(Reader const &) = delete;
+		Reader &operator=(Reader const &) = delete;
+
+		//copy the latest snapshot into 'sim' (resetting it to a continuous, non-sparse board of the snapshot's size as needed);
+		// returns false if nothing new has been published since the last call:
+		bool read_latest(BoardSim *sim, uint64_t *tick = nullptr);
+
+		std::string name;
+		size_t bytes = 0;
+		void *mapping = nullptr;
+		Header const *header = nullptr;
+		uint64_t last_read = 0; //value of header->published at last successful read
+	};
+}
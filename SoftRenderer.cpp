@@ -0,0 +1,326 @@
+#include "SoftRenderer.hpp"
+
+#include "read_chunk.hpp" //helper for reading a vector of structures from a file
+#include "data_path.hpp" //helper to get paths relative to executable
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+//lighting, as set by BoardRenderer::draw:
+static glm::vec3 const SunColor = glm::vec3(0.81f, 0.81f, 0.76f);
+static glm::vec3 const SunDirection = glm::normalize(glm::vec3(-0.2f, 0.2f, 1.0f));
+static glm::vec3 const SkyColor = glm::vec3(0.2f, 0.2f, 0.3f);
+static glm::vec3 const SkyDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+
+//clear color, as set by main.cpp:
+static glm::vec4 const ClearColor = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
+
+//run fn(0) ... fn(count-1) in parallel, with fn(0) on the calling thread:
+template< typename F >
+static void run_threads(uint32_t count, F const &fn) {
+	std::vector< std::thread > extra;
+	extra.reserve(count - 1);
+	for (uint32_t t = 1; t < count; ++t) {
+		extra.emplace_back(fn, t);
+	}
+	fn(0);
+	for (auto &thread : extra) {
+		thread.join();
+	}
+}
+
+SoftRenderer::SoftRenderer() : SoftRenderer(std::make_shared< Meshes const >(data_path("meshes.blob"))) {
+}
+
+SoftRenderer::SoftRenderer(std::string const &path) : SoftRenderer(std::make_shared< Meshes const >(path)) {
+}
+
+SoftRenderer::SoftRenderer(std::shared_ptr< Meshes const > const &meshes_) : meshes(meshes_) {
+	if (!meshes) throw std::runtime_error("SoftRenderer needs meshes.");
+}
+
+SoftRenderer::Meshes::Meshes(std::string const &path) {
+	//same format as BoardRenderer reads: vertex data (see MeshVertices.hpp), then characters, then an index mapping names to vertex ranges:
+	std::ifstream blob(path, std::ios::binary);
+	if (!blob) {
+		throw std::runtime_error("Failed to open '" + path + "'.");
+	}
+	{
+		MeshVertices mesh_vertices;
+		mesh_vertices.read(blob);
+		vertices = mesh_vertices.expanded();
+	}
+
+	std::vector< char > names;
+	read_chunk(blob, "str0", &names);
+
+	struct IndexEntry {
+		uint32_t name_begin;
+		uint32_t name_end;
+		uint32_t vertex_begin;
+		uint32_t vertex_end;
+	};
+	static_assert(sizeof(IndexEntry) == 16, "IndexEntry should be packed.");
+
+	std::vector< IndexEntry > index_entries;
+	read_chunk(blob, "idx0", &index_entries);
+
+	std::map< std::string, Mesh > index;
+	for (IndexEntry const &e : index_entries) {
+		if (e.name_begin > e.name_end || e.name_end > names.size()) {
+			throw std::runtime_error("invalid name indices in index.");
+		}
+		if (e.vertex_begin > e.vertex_end || e.vertex_end > vertices.size()) {
+			throw std::runtime_error("invalid vertex indices in index.");
+		}
+		Mesh mesh;
+		mesh.first = e.vertex_begin;
+		mesh.count = e.vertex_end - e.vertex_begin;
+		if (!index.insert(std::make_pair(std::string(names.begin() + e.name_begin, names.begin() + e.name_end), mesh)).second) {
+			throw std::runtime_error("duplicate name in index.");
+		}
+	}
+
+	auto lookup = [&index](std::string const &name) -> Mesh {
+		auto f = index.find(name);
+		if (f == index.end()) {
+			throw std::runtime_error("Mesh named '" + name + "' does not appear in index.");
+		}
+		return f->second;
+	};
+	tile_mesh = lookup("Tile");
+	cursor_mesh = lookup("Cursor");
+	board_meshes[BoardSim::Doll] = lookup("Doll");
+	board_meshes[BoardSim::Egg] = lookup("Egg");
+	board_meshes[BoardSim::Cube] = lookup("Cube");
+}
+
+void SoftRenderer::render(BoardSim const &sim, glm::uvec2 size, std::vector< glm::u8vec4 > *image) {
+	image->resize(size.x * size.y);
+	if (size.x == 0 || size.y == 0) return;
+
+	//same transformation as BoardRenderer::draw (fit the board in the image):
+	glm::mat4 world_to_clip;
+	{
+		float aspect = float(size.x) / float(size.y);
+		float scale = glm::min(
+			2.0f * aspect / float(sim.board_size.x),
+			2.0f / float(sim.board_size.y)
+		);
+		glm::vec2 center = 0.5f * glm::vec2(sim.board_size);
+		world_to_clip = glm::mat4(
+			scale / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, scale, 0.0f, 0.0f,
+			0.0f, 0.0f,-1.0f, 0.0f,
+			-(scale / aspect) * center.x, -scale * center.y, 0.0f, 1.0f
+		);
+	}
+
+	//same draws as BoardRenderer::draw, in the same order:
+	instances.clear();
+	sim.for_each_rotation([&](uint32_t x, uint32_t y, glm::quat const &rotation){
+		Instance tile;
+		tile.mesh = meshes->tile_mesh;
+		tile.object_to_world = glm::mat4(1.0f);
+		tile.object_to_world[3] = glm::vec4(x+0.5f, y+0.5f,-0.5f, 1.0f);
+		instances.emplace_back(tile);
+
+		Instance mesh;
+		mesh.mesh = meshes->board_meshes[sim.board_meshes[y*sim.board_size.x+x]];
+		mesh.object_to_world = glm::mat4_cast(rotation);
+		mesh.object_to_world[3] = glm::vec4(x+0.5f, y+0.5f, 0.0f, 1.0f);
+		instances.emplace_back(mesh);
+	});
+	Instance cursor;
+	cursor.mesh = meshes->cursor_mesh;
+	cursor.object_to_world = glm::mat4(1.0f);
+	cursor.object_to_world[3] = glm::vec4(sim.cursor.x+0.5f, sim.cursor.y+0.5f, 0.0f, 1.0f);
+	instances.emplace_back(cursor);
+
+	uint32_t thread_count = std::max(1U, std::min(threads, uint32_t(instances.size())));
+	glm::uvec2 tiles = (size + glm::uvec2(TileSize - 1)) / glm::uvec2(TileSize);
+	workers.resize(thread_count);
+
+	//pass 1: transform and bin contiguous ranges of instances (so bins stay in submission order):
+	run_threads(thread_count, [&](uint32_t t){
+		Worker &worker = workers[t];
+		worker.triangles.clear();
+		worker.bins.resize(tiles.x * tiles.y);
+		for (auto &bin : worker.bins) bin.clear();
+		uint32_t begin = uint32_t(uint64_t(instances.size()) * t / thread_count);
+		uint32_t end = uint32_t(uint64_t(instances.size()) * (t + 1) / thread_count);
+		transform_and_bin(worker, begin, end, world_to_clip, size, tiles);
+	});
+
+	//pass 2: rasterize tiles, handed out one at a time:
+	std::atomic< uint32_t > next_tile(0);
+	run_threads(std::min(thread_count, tiles.x * tiles.y), [&](uint32_t){
+		for (uint32_t i = next_tile.fetch_add(1); i < tiles.x * tiles.y; i = next_tile.fetch_add(1)) {
+			rasterize_tile(glm::uvec2(i % tiles.x, i / tiles.x), size, image);
+		}
+	});
+}
+
+void SoftRenderer::transform_and_bin(Worker &worker, uint32_t begin, uint32_t end, glm::mat4 const &world_to_clip, glm::uvec2 size, glm::uvec2 tiles) {
+	glm::vec2 const half_size = 0.5f * glm::vec2(size);
+	for (uint32_t i = begin; i < end; ++i) {
+		Instance const &instance = instances[i];
+		glm::mat4 object_to_clip = world_to_clip * instance.object_to_world;
+		glm::mat3 normal_to_world = glm::inverse(glm::transpose(glm::mat3(instance.object_to_world)));
+
+		for (uint32_t v = instance.mesh.first; v + 2 < instance.mesh.first + instance.mesh.count; v += 3) {
+			Triangle tri;
+			glm::vec2 p[3];
+			for (uint32_t k = 0; k < 3; ++k) {
+				Vertex const &vertex = meshes->vertices[v + k];
+				glm::vec4 clip = object_to_clip * glm::vec4(vertex.Position, 1.0f);
+				//(the board camera is orthographic, so clip.w is 1 and screen-space interpolation is exact)
+				glm::vec3 ndc = glm::vec3(clip) / clip.w;
+				p[k] = (glm::vec2(ndc) + glm::vec2(1.0f)) * half_size;
+				tri.z[k] = 0.5f * ndc.z + 0.5f;
+				tri.normal[k] = normal_to_world * vertex.Normal;
+				tri.color[k] = glm::vec4(vertex.Color) / 255.0f;
+			}
+			//entirely in front of the near plane or behind the far plane?
+			if ((tri.z[0] < 0.0f && tri.z[1] < 0.0f && tri.z[2] < 0.0f) || (tri.z[0] > 1.0f && tri.z[1] > 1.0f && tri.z[2] > 1.0f)) continue;
+
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+			if (!(std::abs(area) > 1e-8f)) continue; //degenerate (or NaN)
+			float sign = (area > 0.0f ? 1.0f : -1.0f); //(both windings are drawn; there is no culling in the GL path)
+			for (uint32_t k = 0; k < 3; ++k) {
+				glm::vec2 const &from = p[(k + 1) % 3];
+				glm::vec2 const &to = p[(k + 2) % 3];
+				tri.a[k] = sign * (from.y - to.y);
+				tri.b[k] = sign * (to.x - from.x);
+				tri.c[k] = -(tri.a[k] * from.x + tri.b[k] * from.y);
+				tri.top_left[k] = (tri.a[k] > 0.0f || (tri.a[k] == 0.0f && tri.b[k] < 0.0f));
+			}
+			tri.inv_area = 1.0f / (sign * area);
+			tri.z_min = std::min(tri.z[0], std::min(tri.z[1], tri.z[2]));
+
+			//pixels whose centers might be covered:
+			glm::vec2 lo = glm::min(p[0], glm::min(p[1], p[2]));
+			glm::vec2 hi = glm::max(p[0], glm::max(p[1], p[2]));
+			tri.min = glm::max(glm::ivec2(glm::ceil(lo - glm::vec2(0.5f))), glm::ivec2(0));
+			tri.max = glm::min(glm::ivec2(glm::floor(hi - glm::vec2(0.5f))), glm::ivec2(size) - glm::ivec2(1));
+			if (tri.min.x > tri.max.x || tri.min.y > tri.max.y) continue;
+
+			uint32_t index = uint32_t(worker.triangles.size());
+			worker.triangles.emplace_back(tri);
+			for (int32_t ty = tri.min.y / int32_t(TileSize); ty <= tri.max.y / int32_t(TileSize); ++ty) {
+				for (int32_t tx = tri.min.x / int32_t(TileSize); tx <= tri.max.x / int32_t(TileSize); ++tx) {
+					worker.bins[ty * tiles.x + tx].emplace_back(index);
+				}
+			}
+		}
+	}
+}
+
+void SoftRenderer::rasterize_tile(glm::uvec2 tile, glm::uvec2 size, std::vector< glm::u8vec4 > *image) {
+	glm::ivec2 origin = glm::ivec2(tile * glm::uvec2(TileSize));
+	glm::ivec2 extent = glm::min(glm::ivec2(TileSize), glm::ivec2(size) - origin);
+	uint32_t tile_index = tile.y * ((size.x + TileSize - 1) / TileSize) + tile.x;
+
+	float depth[TileSize * TileSize];
+	glm::vec4 color[TileSize * TileSize];
+	float block_far[TileBlocks * TileBlocks]; //farthest depth in each block
+	std::fill(depth, depth + TileSize * TileSize, 1.0f);
+	std::fill(color, color + TileSize * TileSize, ClearColor);
+	std::fill(block_far, block_far + TileBlocks * TileBlocks, 1.0f);
+
+	auto draw = [&](Triangle const &tri) {
+		glm::ivec2 lo = glm::max(tri.min, origin) - origin;
+		glm::ivec2 hi = glm::min(tri.max, origin + extent - glm::ivec2(1)) - origin;
+		for (int32_t by = lo.y / int32_t(BlockSize); by <= hi.y / int32_t(BlockSize); ++by) {
+			for (int32_t bx = lo.x / int32_t(BlockSize); bx <= hi.x / int32_t(BlockSize); ++bx) {
+				float &far = block_far[by * TileBlocks + bx];
+				if (tri.z_min >= far) continue; //behind everything already in the block
+
+				//edge values at the center of the block's first pixel; skip the block if all four corners are outside an edge:
+				float px = float(origin.x + bx * int32_t(BlockSize)) + 0.5f;
+				float py = float(origin.y + by * int32_t(BlockSize)) + 0.5f;
+				float e_start[3];
+				bool outside = false;
+				for (uint32_t k = 0; k < 3; ++k) {
+					e_start[k] = tri.a[k] * px + tri.b[k] * py + tri.c[k];
+					float e_max = e_start[k] + (std::max(tri.a[k], 0.0f) + std::max(tri.b[k], 0.0f)) * float(BlockSize - 1);
+					if (e_max < 0.0f) outside = true;
+				}
+				if (outside) continue;
+
+				bool written = false;
+				for (uint32_t row = 0; row < BlockSize; ++row) {
+					int32_t y = by * int32_t(BlockSize) + int32_t(row);
+					if (y >= extent.y) break;
+
+					//edge functions and coverage for the 8 pixels of this block row:
+					float e[3][BlockSize];
+					for (uint32_t k = 0; k < 3; ++k) {
+						float start = e_start[k] + tri.b[k] * float(row);
+						for (uint32_t l = 0; l < BlockSize; ++l) {
+							e[k][l] = start + tri.a[k] * float(l);
+						}
+					}
+					int32_t covered[BlockSize];
+					for (uint32_t l = 0; l < BlockSize; ++l) {
+						covered[l] = ((e[0][l] > 0.0f) | ((e[0][l] == 0.0f) & tri.top_left[0]))
+						           & ((e[1][l] > 0.0f) | ((e[1][l] == 0.0f) & tri.top_left[1]))
+						           & ((e[2][l] > 0.0f) | ((e[2][l] == 0.0f) & tri.top_left[2]));
+					}
+
+					for (uint32_t l = 0; l < BlockSize; ++l) {
+						int32_t x = bx * int32_t(BlockSize) + int32_t(l);
+						if (!covered[l] || x >= extent.x) continue;
+						float w0 = e[0][l] * tri.inv_area, w1 = e[1][l] * tri.inv_area, w2 = e[2][l] * tri.inv_area;
+						float z = w0 * tri.z[0] + w1 * tri.z[1] + w2 * tri.z[2];
+						float &d = depth[y * TileSize + x];
+						if (!(z < d) || z < 0.0f) continue; //depth test (GL_LESS) and near plane
+
+						//simple_shading's fragment shader:
+						glm::vec3 n = glm::normalize(w0 * tri.normal[0] + w1 * tri.normal[1] + w2 * tri.normal[2]);
+						glm::vec4 c = w0 * tri.color[0] + w1 * tri.color[1] + w2 * tri.color[2];
+						glm::vec3 light = (0.5f + 0.5f * glm::dot(n, SkyDirection)) * SkyColor
+							+ std::max(0.0f, glm::dot(n, SunDirection)) * SunColor;
+						glm::vec4 fragment = glm::vec4(glm::vec3(c) * light, c.w);
+
+						//blending as in main.cpp (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA):
+						glm::vec4 &dst = color[y * TileSize + x];
+						dst = fragment * fragment.w + dst * (1.0f - fragment.w);
+						d = z;
+						written = true;
+					}
+				}
+
+				if (written) {
+					far = 0.0f;
+					for (int32_t y = by * int32_t(BlockSize); y < std::min((by + 1) * int32_t(BlockSize), extent.y); ++y) {
+						for (int32_t x = bx * int32_t(BlockSize); x < std::min((bx + 1) * int32_t(BlockSize), extent.x); ++x) {
+							far = std::max(far, depth[y * TileSize + x]);
+						}
+					}
+				}
+			}
+		}
+	};
+
+	for (Worker const &worker : workers) {
+		for (uint32_t index : worker.bins[tile_index]) {
+			draw(worker.triangles[index]);
+		}
+	}
+
+	//write out (flipping, since the image is top row first):
+	for (int32_t y = 0; y < extent.y; ++y) {
+		glm::u8vec4 *out = &(*image)[(size.y - 1 - (origin.y + y)) * size.x + origin.x];
+		for (int32_t x = 0; x < extent.x; ++x) {
+			out[x] = glm::u8vec4(glm::clamp(color[y * TileSize + x], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "BoardSim.hpp"
+#include "MeshVertices.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+//SoftRenderer draws a BoardSim on the CPU, without OpenGL (e.g., for render farms without GPUs):
+// same meshes (the "dat0" vertices of meshes.blob), same camera, and the same sun/sky lighting
+// as BoardRenderer's simple_shading program, with depth testing and alpha blending as main.cpp
+// sets them up.
+//
+//Rendering runs in two parallel passes:
+// 1. transform + bin: threads transform contiguous ranges of mesh instances to screen-space
+//    triangles, and append each triangle to the bins of the TileSize x TileSize screen tiles
+//    its bounding box overlaps;
+// 2. rasterize: threads take tiles one at a time and draw the tile's triangles (in submission
+//    order, so blending matches the GL path) into a tile-sized color and depth buffer.
+//Within a tile, triangles are walked in BlockSize x BlockSize blocks: a block is skipped if its
+// corners are all outside one edge, or if the triangle is entirely behind everything already
+// drawn in the block (a per-block farthest depth, i.e., a one-level hierarchical depth buffer).
+//Edge functions are evaluated a block row (8 pixels) at a time in fixed-size loops that
+// compilers turn into SIMD code.
+struct SoftRenderer {
+	struct Meshes;
+
+	//load meshes from meshes.blob (next to the executable, as BoardRenderer does) or from 'path':
+	SoftRenderer();
+	explicit SoftRenderer(std::string const &path);
+	//use meshes already loaded (e.g., by another renderer -- see 'meshes' below):
+	explicit SoftRenderer(std::shared_ptr< Meshes const > const &meshes);
+
+	//render 'sim' at 'size' pixels into 'image' (RGBA, top row first):
+	void render(BoardSim const &sim, glm::uvec2 size, std::vector< glm::u8vec4 > *image);
+
+	uint32_t threads = 1; //worker threads used by render() (1 renders on the calling thread only)
+
+	//------- mesh data -------
+
+	typedef MeshVertices::Vertex Vertex; //(paletted colors are looked up at load)
+
+	struct Mesh {
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	//read-only once loaded, so renderers on different threads can share one copy:
+	struct Meshes {
+		explicit Meshes(std::string const &path); //throws on failure
+
+		std::vector< Vertex > vertices;
+		Mesh tile_mesh;
+		Mesh cursor_mesh;
+		Mesh board_meshes[BoardSim::MeshIdCount]; //indexed by BoardSim::MeshId
+	};
+	std::shared_ptr< Meshes const > meshes;
+
+	//------- rendering internals -------
+
+	enum : uint32_t {
+		TileSize = 64,
+		BlockSize = 8,
+		TileBlocks = TileSize / BlockSize,
+	};
+
+	//a screen-space triangle, set up for rasterization (pixel (x,y) has its center at (x+0.5,y+0.5), y up):
+	struct Triangle {
+		//edge functions: e[i](x,y) = a[i] * x + b[i] * y + c[i], positive inside;
+		// e[i] is zero on the edge opposite vertex i, so e[i] * inv_area is vertex i's barycentric weight:
+		float a[3], b[3], c[3];
+		float inv_area;
+		bool top_left[3]; //whether pixels exactly on edge i are inside (the usual top-left fill rule)
+		float z[3]; //window-space depth per vertex
+		float z_min;
+		glm::vec3 normal[3];
+		glm::vec4 color[3];
+		glm::ivec2 min, max; //pixel bounding box (inclusive), clamped to the image
+	};
+
+	//per-thread transform/bin results:
+	struct Worker {
+		std::vector< Triangle > triangles;
+		std::vector< std::vector< uint32_t > > bins; //per screen tile, indices into 'triangles'
+	};
+	std::vector< Worker > workers;
+
+	struct Instance {
+		Mesh mesh;
+		glm::mat4 object_to_world;
+	};
+	std::vector< Instance > instances;
+
+	void transform_and_bin(Worker &worker, uint32_t begin, uint32_t end, glm::mat4 const &world_to_clip, glm::uvec2 size, glm::uvec2 tiles);
+	void rasterize_tile(glm::uvec2 tile, glm::uvec2 size, std::vector< glm::u8vec4 > *image);
+};
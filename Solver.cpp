@@ -0,0 +1,319 @@
+#include "Solver.hpp"
+
+#include "BoardSim.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+	//number of quarter turns from the identity to each orientation
+	// (breadth-first search over the group, using the four rolls as generators):
+	struct TurnTable {
+		uint8_t turns[CubeRotations::Count];
+		uint8_t max_turns = 0;
+		TurnTable() {
+			for (auto &t : turns) t = 0xff;
+			std::vector< uint8_t > queue;
+			turns[CubeRotations::Identity] = 0;
+			queue.emplace_back(CubeRotations::Identity);
+			for (uint32_t i = 0; i < queue.size(); ++i) {
+				uint8_t at = queue[i];
+				for (uint32_t r = 0; r < CubeRotations::RollCount; ++r) {
+					uint8_t next = CubeRotations::tables.roll[r][at];
+					if (turns[next] == 0xff) {
+						turns[next] = turns[at] + 1;
+						max_turns = std::max(max_turns, turns[next]);
+						queue.emplace_back(next);
+					}
+				}
+			}
+		}
+	};
+	TurnTable const turn_table;
+
+	//opposite roll (undoes a quarter turn):
+	inline CubeRotations::Roll opposite(uint32_t roll) {
+		static CubeRotations::Roll const opposites[CubeRotations::RollCount] = {
+			CubeRotations::RollRight, CubeRotations::RollLeft, CubeRotations::RollDown, CubeRotations::RollUp
+		};
+		return opposites[roll];
+	}
+
+	//rolls about the same axis commute (RollLeft/RollRight turn about y, RollUp/RollDown about x):
+	inline uint32_t axis(uint32_t roll) {
+		return roll / 2;
+	}
+
+	//shared between threads for one solve:
+	struct Shared {
+		std::atomic< uint64_t > *table = nullptr; //transposition table
+		uint64_t table_mask = 0;
+		uint32_t tag = 0; //iteration tag for table entries
+		std::atomic< uint32_t > next_root{0}; //next root move to hand out
+		std::atomic< bool > found{false};
+		std::mutex solution_mutex;
+		std::vector< Solver::Move > solution;
+		std::atomic< uint64_t > nodes{0};
+	};
+
+	//per-thread search state:
+	struct Search {
+		Search(Solver const &solver_, Shared &shared_, std::vector< uint8_t > const &start, std::vector< uint8_t > const &goal_)
+			: solver(solver_), shared(shared_), goal(goal_), board(start), cell_turns(start.size()) {
+			cross_length = solver.board_size.x + solver.board_size.y - 1;
+			for (uint32_t i = 0; i < board.size(); ++i) {
+				cell_turns[i] = Solver::turns_between(board[i], goal[i]);
+				turn_sum += cell_turns[i];
+				turn_count[cell_turns[i]] += 1;
+				hash ^= solver.zobrist[i * CubeRotations::Count + board[i]];
+			}
+		}
+
+		//cheap lower bound on moves remaining: the most turns any one cell needs,
+		// and the total turns needed spread over the cells a roll touches:
+		uint32_t heuristic() const {
+			uint32_t max_turns = turn_table.max_turns;
+			while (max_turns > 0 && turn_count[max_turns] == 0) --max_turns;
+			return std::max(max_turns, (turn_sum + cross_length - 1) / cross_length);
+		}
+
+		//true if the remaining moves certainly exceed 'limit';
+		// a roll touches at most two cells of a set with no two cells sharing a row or column,
+		// so half the turns needed by such a set (chosen greedily, biggest first) is also a bound:
+		bool exceeds(uint32_t limit) const {
+			if (heuristic() > limit) return true;
+			glm::uvec2 size = solver.board_size;
+			if (size.x > 64 || size.y > 64) return false;
+			uint32_t picks = std::min(size.x, size.y);
+			if ((picks * turn_table.max_turns + 1) / 2 <= limit) return false; //can't help
+
+			uint64_t used_x = 0, used_y = 0;
+			uint32_t set_sum = 0;
+			for (uint32_t n = 0; n < picks; ++n) {
+				uint32_t best = 0, best_x = 0, best_y = 0;
+				for (uint32_t y = 0, i = 0; y < size.y; ++y) {
+					if ((used_y >> y) & 1) { i += size.x; continue; }
+					for (uint32_t x = 0; x < size.x; ++x, ++i) {
+						if (cell_turns[i] > best && !((used_x >> x) & 1)) {
+							best = cell_turns[i];
+							best_x = x;
+							best_y = y;
+						}
+					}
+				}
+				if (best == 0) break;
+				set_sum += best;
+				if ((set_sum + 1) / 2 > limit) return true;
+				used_x |= uint64_t(1) << best_x;
+				used_y |= uint64_t(1) << best_y;
+			}
+			return false;
+		}
+
+		//apply roll to cross at cursor index c, updating hash and heuristic terms:
+		void apply(uint32_t c, uint32_t roll) {
+			uint8_t const *table = CubeRotations::tables.roll[roll];
+			for (uint32_t i : solver.crosses[c]) {
+				uint8_t &o = board[i];
+				hash ^= solver.zobrist[i * CubeRotations::Count + o];
+				o = table[o];
+				hash ^= solver.zobrist[i * CubeRotations::Count + o];
+
+				uint8_t t = Solver::turns_between(o, goal[i]);
+				turn_sum = turn_sum - cell_turns[i] + t;
+				turn_count[cell_turns[i]] -= 1;
+				turn_count[t] += 1;
+				cell_turns[i] = t;
+			}
+		}
+
+		//returns true if the transposition table shows this position was already searched
+		// in this iteration with at most 'g' moves; otherwise records it:
+		bool seen(uint32_t g) {
+			std::atomic< uint64_t > &entry = shared.table[hash & shared.table_mask];
+			uint64_t old = entry.load(std::memory_order_relaxed);
+			if ((old >> 16) == (hash >> 16) && ((old >> 8) & 0xff) == shared.tag && (old & 0xff) <= g) {
+				return true;
+			}
+			entry.store((hash & ~uint64_t(0xffff)) | (uint64_t(shared.tag) << 8) | uint64_t(g), std::memory_order_relaxed);
+			return false;
+		}
+
+		bool dfs(uint32_t g, uint32_t bound, uint32_t last_c, uint32_t last_roll, uint32_t repeats) {
+			++nodes;
+			if (turn_sum == 0) return true;
+			if (exceeds(bound - g)) return false;
+			if (shared.found.load(std::memory_order_relaxed)) return false;
+			if (seen(g)) return false;
+
+			for (uint32_t c = 0; c < solver.crosses.size(); ++c) {
+				for (uint32_t roll = 0; roll < CubeRotations::RollCount; ++roll) {
+					if (c == last_c) {
+						//undoing the previous move is never shortest:
+						if (roll == opposite(last_roll)) continue;
+						//three of the same quarter turn equal one opposite turn:
+						if (roll == last_roll && repeats >= 2) continue;
+					} else if (c < last_c && axis(roll) == axis(last_roll)) {
+						//turns about the same axis commute, so only search them in increasing cursor order:
+						continue;
+					}
+					apply(c, roll);
+					path.emplace_back(c, roll);
+					if (dfs(g + 1, bound, c, roll, (c == last_c && roll == last_roll ? repeats + 1 : 1))) return true;
+					path.pop_back();
+					apply(c, opposite(roll));
+				}
+			}
+			return false;
+		}
+
+		Solver const &solver;
+		Shared &shared;
+		std::vector< uint8_t > const &goal;
+
+		std::vector< uint8_t > board;
+		std::vector< uint8_t > cell_turns; //turns_between(board[i], goal[i])
+		uint32_t turn_sum = 0;
+		uint32_t turn_count[16] = {}; //number of cells needing each number of turns
+		uint32_t cross_length = 1;
+		uint64_t hash = 0;
+		std::vector< std::pair< uint32_t, uint32_t > > path; //(cursor index, roll)
+		uint64_t nodes = 0;
+	};
+}
+
+Solver::Solver(glm::uvec2 board_size_, Options const &options_) : board_size(board_size_), options(options_) {
+	if (board_size.x == 0 || board_size.y == 0 || board_size.x > 0xffff || board_size.y > 0xffff) {
+		throw std::runtime_error("Solver needs a non-empty board no larger than 65535x65535.");
+	}
+	if (options.threads == 0) options.threads = 1;
+	options.table_bits = std::min(options.table_bits, 32U);
+	options.max_depth = std::min(options.max_depth, 255U);
+
+	uint32_t cells = board_size.x * board_size.y;
+	crosses.resize(cells);
+	for (uint32_t y = 0; y < board_size.y; ++y) {
+		for (uint32_t x = 0; x < board_size.x; ++x) {
+			auto &cross = crosses[y * board_size.x + x];
+			for (uint32_t cx = 0; cx < board_size.x; ++cx) {
+				cross.emplace_back(y * board_size.x + cx);
+			}
+			for (uint32_t cy = 0; cy < board_size.y; ++cy) {
+				if (cy != y) cross.emplace_back(cy * board_size.x + x);
+			}
+		}
+	}
+
+	//fixed seed, so hashes are reproducible between runs:
+	std::mt19937_64 mt(0x5eed2b0a4d51ULL);
+	zobrist.resize(size_t(cells) * CubeRotations::Count);
+	for (auto &z : zobrist) z = mt();
+
+	table.reset(new std::atomic< uint64_t >[size_t(1) << options.table_bits]);
+	table_mask = (uint64_t(1) << options.table_bits) - 1;
+	iteration_tag = 0xff; //forces clear on first use
+}
+
+uint8_t Solver::turns_between(uint8_t from, uint8_t to) {
+	using namespace CubeRotations;
+	return turn_table.turns[tables.compose[to][tables.inverse[from]]];
+}
+
+void Solver::apply(std::vector< uint8_t > *board, glm::uvec2 board_size, Move const &move) {
+	BoardSim::roll_cross_discrete(board->data(), board_size, glm::uvec2(move.x, move.y), move.roll);
+}
+
+Solver::Result Solver::solve(std::vector< uint8_t > const &start, std::vector< uint8_t > const &goal) {
+	uint32_t cells = board_size.x * board_size.y;
+	if (start.size() != cells || goal.size() != cells) {
+		throw std::runtime_error("Solver board does not match board size.");
+	}
+
+	auto before = std::chrono::steady_clock::now();
+	Result result;
+
+	Shared shared;
+	shared.table = table.get();
+	shared.table_mask = table_mask;
+
+	Search root(*this, shared, start, goal);
+	uint32_t root_moves = cells * CubeRotations::RollCount;
+
+	if (root.turn_sum == 0) {
+		result.solved = true;
+	} else {
+		result.lower_bound = std::max(1U, root.heuristic()); //(even if that is already past max_depth)
+		for (uint32_t bound = std::max(1U, root.heuristic()); bound <= options.max_depth; ++bound) {
+			shared.next_root.store(0);
+
+			//new tag for this iteration's table entries (tag 0 is never used, so cleared entries never match):
+			iteration_tag += 1;
+			if (iteration_tag > 0xff) {
+				for (size_t i = 0; i <= table_mask; ++i) {
+					table[i].store(0, std::memory_order_relaxed);
+				}
+				iteration_tag = 1;
+			}
+			shared.tag = iteration_tag;
+
+			//each worker takes first moves from the shared counter and searches below them:
+			auto worker = [&]() {
+				Search search(*this, shared, start, goal);
+				while (!shared.found.load()) {
+					uint32_t m = shared.next_root.fetch_add(1);
+					if (m >= root_moves) break;
+					uint32_t c = m / CubeRotations::RollCount, roll = m % CubeRotations::RollCount;
+					search.apply(c, roll);
+					search.path.emplace_back(c, roll);
+					if (search.dfs(1, bound, c, roll, 1)) {
+						std::lock_guard< std::mutex > lock(shared.solution_mutex);
+						if (!shared.found.load()) {
+							for (auto const &step : search.path) {
+								Move move;
+								move.x = uint16_t(step.first % board_size.x);
+								move.y = uint16_t(step.first / board_size.x);
+								move.roll = CubeRotations::Roll(step.second);
+								shared.solution.emplace_back(move);
+							}
+							shared.found.store(true);
+						}
+						break;
+					}
+					search.path.pop_back();
+					search.apply(c, opposite(roll));
+				}
+				shared.nodes.fetch_add(search.nodes);
+			};
+
+			if (options.threads == 1) {
+				worker();
+			} else {
+				std::vector< std::thread > threads;
+				for (uint32_t t = 0; t < options.threads; ++t) {
+					threads.emplace_back(worker);
+				}
+				for (auto &thread : threads) {
+					thread.join();
+				}
+			}
+
+			result.depth_searched = bound;
+			result.lower_bound = bound + 1;
+			if (shared.found.load()) {
+				result.solved = true;
+				result.moves = shared.solution;
+				break;
+			}
+		}
+	}
+
+	result.nodes = shared.nodes.load() + root.nodes;
+	result.seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+	return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CubeRotations.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+//Solver finds shortest sequences of discrete rolls (quarter turns of the row+column
+// crossing at a cell) that take a board of CubeRotations orientations to a goal.
+//
+//Search is iterative-deepening A* (IDA*), parallelized by splitting the first moves of
+// each iteration across threads. Threads share a lock-free transposition table keyed
+// by an incrementally maintained Zobrist hash, so positions reached by another thread
+// (or another move order) at no greater depth are not searched again.
+//The heuristic is the largest of: the most quarter turns any single cell needs, the
+// total quarter turns needed divided by the number of cells a roll touches, and half the
+// turns needed by a set of cells with no two in the same row or column (a roll touches
+// at most two of them). Rolls about the same axis commute, so they are only searched in
+// one order.
+
+struct Solver {
+	struct Move {
+		uint16_t x = 0, y = 0; //cursor (the row y and column x are rolled)
+		CubeRotations::Roll roll = CubeRotations::NoRoll;
+	};
+
+	struct Options {
+		uint32_t threads = 1;
+		uint32_t max_depth = 12; //give up beyond this many moves
+		uint32_t table_bits = 20; //transposition table has 2^table_bits entries
+	};
+
+	struct Result {
+		bool solved = false;
+		std::vector< Move > moves; //apply in order to reach the goal
+		uint32_t depth_searched = 0; //last IDA* bound completed (or solution length)
+		uint32_t lower_bound = 0; //if not solved, fewest moves a solution could take (the root heuristic, or one past the last bound searched)
+		uint64_t nodes = 0; //positions expanded
+		double seconds = 0.0;
+	};
+
+	Solver(glm::uvec2 board_size, Options const &options);
+
+	//solve from 'start' to 'goal' (row-major CubeRotations indices, board_size.x * board_size.y each);
+	// uses options.threads threads internally, but a Solver should only be used by one caller at a time:
+	Result solve(std::vector< uint8_t > const &start, std::vector< uint8_t > const &goal);
+
+	//quarter turns (by any of the four rolls) needed to take orientation 'from' to 'to':
+	static uint8_t turns_between(uint8_t from, uint8_t to);
+
+	//apply a move to a board (for checking / replaying solutions):
+	static void apply(std::vector< uint8_t > *board, glm::uvec2 board_size, Move const &move);
+
+	glm::uvec2 board_size;
+	Options options;
+
+	std::vector< std::vector< uint32_t > > crosses; //cell indices touched by a move at each cursor
+	std::vector< uint64_t > zobrist; //zobrist[cell * CubeRotations::Count + orientation]
+
+	//transposition table entries are (high 48 bits of hash | iteration tag << 8 | depth);
+	// the tag changes every IDA* iteration, so the table only needs clearing when the tag wraps:
+	std::unique_ptr< std::atomic< uint64_t >[] > table;
+	uint64_t table_mask = 0;
+	uint32_t iteration_tag = 0;
+};
@@ -0,0 +1,27 @@
+#include "SparseRotations.hpp"
+
+void SparseRotations::reset(glm::uvec2 size_) {
+	size = size_;
+	chunks = (size + glm::uvec2(ChunkSize - 1)) / glm::uvec2(ChunkSize);
+	chunk_at.assign(chunks.x * chunks.y, NoChunk);
+	data.clear();
+	chunk_slot.clear();
+}
+
+glm::quat &SparseRotations::at(uint32_t x, uint32_t y) {
+	uint32_t slot = (y / ChunkSize) * chunks.x + (x / ChunkSize);
+	uint32_t chunk = chunk_at[slot];
+	if (chunk == NoChunk) {
+		chunk = uint32_t(chunk_slot.size());
+		chunk_slot.emplace_back(slot);
+		data.resize(data.size() + ChunkCells, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		chunk_at[slot] = chunk;
+	}
+	return data[chunk * ChunkCells + (y % ChunkSize) * ChunkSize + (x % ChunkSize)];
+}
+
+size_t SparseRotations::memory_bytes() const {
+	return chunk_at.capacity() * sizeof(uint32_t)
+		+ data.capacity() * sizeof(glm::quat)
+		+ chunk_slot.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdint>
+
+//SparseRotations stores per-cell rotations for boards where most cells stay at identity.
+//
+//The board is divided into ChunkSize x ChunkSize chunks. A chunk only gets storage (a dense
+// block of ChunkCells quaternions) once one of its cells is written; every cell of an
+// unallocated chunk is implicitly identity. A grid of chunk indices (4 bytes per chunk)
+// makes lookups O(1), so memory and iteration cost scale with the number of active chunks.
+struct SparseRotations {
+	enum : uint32_t {
+		ChunkSize = 8,
+		ChunkCells = ChunkSize * ChunkSize,
+		NoChunk = 0xffffffff,
+	};
+
+	//clear to all-identity:
+	void reset(glm::uvec2 size);
+
+	//rotation of cell (x,y):
+	glm::quat get(uint32_t x, uint32_t y) const {
+		uint32_t chunk = chunk_at[(y / ChunkSize) * chunks.x + (x / ChunkSize)];
+		if (chunk == NoChunk) return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		return data[chunk * ChunkCells + (y % ChunkSize) * ChunkSize + (x % ChunkSize)];
+	}
+
+	//writable rotation of cell (x,y); allocates (identity-filled) storage for its chunk if needed:
+	glm::quat &at(uint32_t x, uint32_t y);
+
+	//call fn(origin, cells) for every allocated chunk, where cells[ly * ChunkSize + lx] is the
+	// rotation of cell origin + (lx,ly) (entries beyond the board edge are identity and unused):
+	template< typename F >
+	void for_each_chunk(F const &fn) const {
+		for (uint32_t c = 0; c < chunk_slot.size(); ++c) {
+			glm::uvec2 origin((chunk_slot[c] % chunks.x) * ChunkSize, (chunk_slot[c] / chunks.x) * ChunkSize);
+			fn(origin, &data[c * ChunkCells]);
+		}
+	}
+
+	uint32_t chunk_count() const { return uint32_t(chunk_slot.size()); }
+	size_t memory_bytes() const;
+
+	glm::uvec2 size = glm::uvec2(0,0); //in cells
+	glm::uvec2 chunks = glm::uvec2(0,0); //in chunks
+	std::vector< uint32_t > chunk_at; //per chunk of the board: index of its storage, or NoChunk
+	std::vector< glm::quat > data; //ChunkCells rotations per allocated chunk
+	std::vector< uint32_t > chunk_slot; //per allocated chunk: its index in chunk_at
+};
@@ -0,0 +1,292 @@
+#include "TextureLoader.hpp"
+
+#include "gl_errors.hpp" //helper for dumpping OpenGL error messages
+#include "load_save_png.hpp" //PNG decoding
+#include "Mipmaps.hpp" //CPU mipmap generation
+#include "BCn.hpp" //block-compressed textures
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+//levels are streamed in rows -- of texels for GL_RGBA8, of 4x4 blocks for compressed formats:
+static size_t row_bytes(GLenum format, glm::uvec2 size) {
+	if (format == GL_RGBA8) return size.x * sizeof(glm::u8vec4);
+	return ((size.x + 3) / 4) * (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16);
+}
+static uint32_t row_count(GLenum format, glm::uvec2 size) {
+	if (format == GL_RGBA8) return size.y;
+	return (size.y + 3) / 4;
+}
+static size_t level_bytes(GLenum format, glm::uvec2 size) {
+	return row_bytes(format, size) * row_count(format, size);
+}
+
+TextureLoader::TextureLoader(uint32_t threads) {
+	if (threads == 0) {
+		threads = std::max(2U, std::thread::hardware_concurrency()) - 1;
+	}
+
+	{ //can '.bcn' textures be uploaded as-is?
+		GLint extensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+		for (GLint i = 0; i < extensions; ++i) {
+			if (std::strcmp(reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, i)), "GL_EXT_texture_compression_s3tc") == 0) {
+				s3tc = true;
+			}
+		}
+	}
+
+	for (Staging &s : staging) {
+		glGenBuffers(1, &s.buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, StagingBytes, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GL_ERRORS();
+
+	for (uint32_t t = 0; t < threads; ++t) {
+		workers.emplace_back([this](){
+			while (true) {
+				Decoded result;
+				{
+					std::unique_lock< std::mutex > lock(mutex);
+					wake.wait(lock, [this](){ return quit || !requests.empty(); });
+					if (quit) return;
+					result.texture = requests.front().first;
+					result.path = requests.front().second;
+					requests.pop_front();
+				}
+
+				try {
+					std::string const &path = result.path;
+					if (path.size() >= 4 && path.substr(path.size() - 4) == ".bcn") {
+						load_bcn(&result);
+					} else {
+						result.levels.emplace_back();
+						load_png(path, &result.levels[0].size, &result.levels[0].pixels, LowerLeftOrigin);
+						build_mipmaps(&result.levels);
+					}
+				} catch (std::exception &e) {
+					result.error = e.what();
+					result.levels.clear();
+				}
+
+				std::unique_lock< std::mutex > lock(mutex);
+				decoded.emplace_back(std::move(result));
+			}
+		});
+	}
+}
+
+TextureLoader::~TextureLoader() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	for (Staging &s : staging) {
+		if (s.fence) glDeleteSync(s.fence);
+		glDeleteBuffers(1, &s.buffer);
+	}
+	glDeleteTextures(GLsizei(textures.size()), textures.data());
+	GL_ERRORS();
+}
+
+GLuint TextureLoader::create_placeholder() {
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glm::u8vec4 white(0xff);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_ERRORS();
+	return texture;
+}
+
+GLuint TextureLoader::white() {
+	if (!white_texture) {
+		white_texture = create_placeholder();
+		textures.emplace_back(white_texture);
+	}
+	return white_texture;
+}
+
+GLuint TextureLoader::load(std::string const &path) {
+	GLuint texture = create_placeholder();
+	textures.emplace_back(texture);
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		requests.emplace_back(texture, path);
+	}
+	wake.notify_one();
+	++outstanding;
+	return texture;
+}
+
+void TextureLoader::update() {
+	{ //collect finished decodes:
+		std::unique_lock< std::mutex > lock(mutex);
+		while (!decoded.empty()) {
+			uploading.emplace_back(std::move(decoded.front()));
+			decoded.pop_front();
+		}
+	}
+
+	size_t budget = upload_budget;
+	while (!uploading.empty() && budget > 0) {
+		Decoded &d = uploading.front();
+		if (!d.error.empty()) {
+			std::cerr << "WARNING: failed to load texture '" << d.path << "' (" << d.error << "); leaving it white." << std::endl;
+			uploading.pop_front();
+			--outstanding;
+			continue;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, d.texture);
+
+		if (!d.allocated) {
+			//allocate every level, and upload the small ones right away, so the texture is never sampled incomplete:
+			for (uint32_t l = 0; l < d.levels.size(); ++l) {
+				Level const &level = d.levels[l];
+				size_t bytes = level_bytes(d.format, level.size);
+				bool direct = (bytes <= DirectBytes);
+				if (d.format == GL_RGBA8) {
+					glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, level.size.x, level.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, direct ? level.pixels.data() : nullptr);
+				} else {
+					glCompressedTexImage2D(GL_TEXTURE_2D, l, d.format, level.size.x, level.size.y, 0, GLsizei(bytes), direct ? level.blocks : nullptr);
+				}
+			}
+			d.level = uint32_t(d.levels.size()) - 1;
+			while (d.level > 0 && level_bytes(d.format, d.levels[d.level - 1].size) <= DirectBytes) {
+				--d.level;
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, d.level);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(d.levels.size()) - 1);
+			d.allocated = true;
+			if (d.level == 0) {
+				uploading.pop_front();
+				--outstanding;
+				continue;
+			}
+			--d.level;
+			d.row = 0;
+		}
+
+		//next band of rows goes through the next pixel buffer in the ring, if the GPU is done with it:
+		Staging &s = staging[next_staging];
+		if (s.fence) {
+			if (glClientWaitSync(s.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+			glDeleteSync(s.fence);
+			s.fence = 0;
+		}
+
+		Level &level = d.levels[d.level];
+		size_t stride = row_bytes(d.format, level.size);
+		uint32_t level_rows = row_count(d.format, level.size);
+		if (stride > StagingBytes) {
+			throw std::runtime_error("Texture '" + d.path + "' is too wide to stream.");
+		}
+		uint32_t rows = std::min(level_rows - d.row, uint32_t(StagingBytes / stride));
+		size_t bytes = rows * stride;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.buffer);
+		//(unsynchronized is safe: the fence above says the GPU is done with this buffer's last contents)
+		void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (!dst) {
+			throw std::runtime_error("Failed to map texture staging buffer.");
+		}
+		uint8_t const *src = (d.format == GL_RGBA8 ? reinterpret_cast< uint8_t const * >(level.pixels.data()) : level.blocks);
+		std::memcpy(dst, src + d.row * stride, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		if (d.format == GL_RGBA8) {
+			glTexSubImage2D(GL_TEXTURE_2D, d.level, 0, d.row, level.size.x, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		} else {
+			//(block rows are 4 texels tall; the last may be cut short by the level's height)
+			uint32_t y = d.row * 4;
+			uint32_t height = std::min(rows * 4, level.size.y - y);
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, d.level, 0, y, level.size.x, height, d.format, GLsizei(bytes), nullptr);
+		}
+		s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		next_staging = (next_staging + 1) % StagingBuffers;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		budget -= std::min(budget, bytes);
+		d.row += rows;
+		if (d.row == level_rows) {
+			//level done; start sampling from it:
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, d.level);
+			std::vector< glm::u8vec4 >().swap(level.pixels);
+			level.blocks = nullptr;
+			if (d.level == 0) {
+				uploading.pop_front();
+				--outstanding;
+			} else {
+				--d.level;
+				d.row = 0;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_ERRORS();
+}
+
+void TextureLoader::build_mipmaps(std::vector< Level > *levels_) {
+	assert(levels_ && levels_->size() == 1);
+	auto &levels = *levels_;
+
+	while (levels.back().size != glm::uvec2(1)) {
+		Level dst;
+		dst.size = mipmap_size(levels.back().size);
+		downsample(levels.back().size, levels.back().pixels, &dst.pixels);
+		levels.emplace_back(std::move(dst));
+	}
+}
+
+void TextureLoader::load_bcn(Decoded *result) const {
+	std::shared_ptr< MappedChunks > file = std::make_shared< MappedChunks >(result->path);
+	BCn::Format format;
+	glm::uvec2 size;
+	std::vector< uint8_t const * > blocks;
+	BCn::map(*file, &format, &size, &blocks);
+
+	if (s3tc) {
+		result->format = (format == BCn::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+		//(blocks are uploaded from the mapping; fault it in here, so the GL thread doesn't wait on the disk)
+		file->touch();
+		result->file = file;
+	} else {
+		result->format = GL_RGBA8;
+	}
+	for (uint8_t const *level_blocks : blocks) {
+		result->levels.emplace_back();
+		Level &level = result->levels.back();
+		level.size = size;
+		if (s3tc) {
+			level.blocks = level_blocks;
+		} else {
+			BCn::decode(format, size, level_blocks, &level.pixels);
+		}
+		size = mipmap_size(size);
+	}
+}
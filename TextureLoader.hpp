@@ -0,0 +1,106 @@
+#pragma once
+
+#include "GL.hpp"
+#include "MappedChunks.hpp"
+
+#include <glm/glm.hpp>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+//TextureLoader loads PNG (and block-compressed '.bcn', see BCn.hpp) textures without stalling frames:
+// - worker threads decode PNGs and build each texture's whole mipmap chain on the CPU
+//   (so textures are decoded and filtered in parallel, off the GL thread);
+// - '.bcn' files already hold their mipmap chain, and are uploaded still compressed if the
+//   driver supports S3TC, straight from the memory-mapped file (otherwise a worker decodes them to RGBA8);
+// - update(), called once per frame on the GL thread, streams decoded levels to the GPU
+//   through a small ring of pixel buffer objects, at most 'upload_budget' bytes per call,
+//   coarsest level first, lowering GL_TEXTURE_BASE_LEVEL as each finer level lands;
+// - a pixel buffer is only reused once its fence shows the GPU has consumed it, which is
+//   checked without waiting: if no buffer is free, uploading picks up again next frame.
+//Until its data arrives (or if it fails to load), a texture is a 1x1 white placeholder.
+struct TextureLoader {
+	//'threads' decoding threads (0: one fewer than the hardware threads, but at least one):
+	explicit TextureLoader(uint32_t threads = 0);
+	~TextureLoader();
+	TextureLoader(TextureLoader const &) = delete;
+	TextureLoader &operator=(TextureLoader const &) = delete;
+
+	//start loading a PNG or '.bcn' file; the texture object is usable right away (as a placeholder):
+	GLuint load(std::string const &path);
+
+	//a 1x1 white texture (e.g., for untextured meshes), created on first use:
+	GLuint white();
+
+	//upload decoded data (call once per frame on the GL thread; leaves GL_TEXTURE_2D unbound):
+	void update();
+
+	//true once every loaded texture is fully uploaded (or has failed):
+	bool idle() const { return outstanding == 0; }
+
+	size_t upload_budget = 8 << 20; //bytes uploaded per update() (levels smaller than a band may go over slightly)
+
+	//------- internals -------
+
+	enum : uint32_t {
+		StagingBuffers = 4, //pixel buffer objects in the upload ring
+		StagingBytes = 4 << 20, //size of each (levels are uploaded in bands of rows that fit)
+		DirectBytes = 16 << 10, //levels at most this big skip the ring (uploaded with the first band)
+	};
+
+	bool s3tc = false; //driver supports GL_EXT_texture_compression_s3tc (set before workers start)
+
+	struct Level {
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > pixels; //bottom row first, as glTexImage2D expects
+		uint8_t const *blocks = nullptr; //for compressed textures: rows of 4x4 blocks, bottom first (in Decoded::file)
+	};
+
+	struct Decoded {
+		GLuint texture = 0;
+		std::string path;
+		std::string error; //if non-empty, decoding failed
+		GLenum format = GL_RGBA8; //or a compressed (S3TC) internal format, stored in Level::blocks
+		std::shared_ptr< MappedChunks > file; //mapped '.bcn' file that compressed levels point into
+		std::vector< Level > levels; //levels[0] is full size, each following level half the last (2x2 box filter)
+		//upload progress (GL thread):
+		bool allocated = false;
+		uint32_t level = 0; //next level to upload (counts down to 0)
+		uint32_t row = 0; //next row (of texels, or of blocks if compressed) of that level
+	};
+
+	//shared between the GL thread and workers (guarded by 'mutex'):
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque< std::pair< GLuint, std::string > > requests;
+	std::deque< Decoded > decoded;
+	bool quit = false;
+
+	std::vector< std::thread > workers;
+
+	//GL thread only:
+	std::deque< Decoded > uploading;
+	uint32_t outstanding = 0; //textures requested but not yet fully uploaded
+	struct Staging {
+		GLuint buffer = 0;
+		GLsync fence = 0; //set after the buffer's last upload was issued
+	};
+	Staging staging[StagingBuffers];
+	uint32_t next_staging = 0;
+	std::vector< GLuint > textures; //every texture created by load() or white()
+	GLuint white_texture = 0;
+
+	static GLuint create_placeholder(); //a new 1x1 white texture
+
+	//fill in levels[1..] from levels[0]:
+	static void build_mipmaps(std::vector< Level > *levels);
+
+	//read a '.bcn' file into 'result' (compressed, or decoded to RGBA8 if !s3tc):
+	void load_bcn(Decoded *result) const;
+};
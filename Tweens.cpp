@@ -0,0 +1,103 @@
+#include "Tweens.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void Tweens::add(uint32_t cell, glm::quat const &from, glm::quat const &to_, float duration) {
+	//take the short way around (q and -q are the same rotation):
+	glm::quat to = to_;
+	float cos_omega = glm::dot(from, to);
+	if (cos_omega < 0.0f) {
+		to = -to;
+		cos_omega = -cos_omega;
+	}
+	//for nearly equal rotations, a small minimum angle keeps 1/sin(omega) finite
+	// (the slerp weights then approach those of lerp):
+	float angle = std::max(std::acos(std::min(cos_omega, 1.0f)), 1e-3f);
+
+	cells.emplace_back(cell);
+	from_x.emplace_back(from.x); from_y.emplace_back(from.y); from_z.emplace_back(from.z); from_w.emplace_back(from.w);
+	to_x.emplace_back(to.x); to_y.emplace_back(to.y); to_z.emplace_back(to.z); to_w.emplace_back(to.w);
+	omega.emplace_back(angle);
+	inv_sin_omega.emplace_back(1.0f / std::sin(angle));
+	t.emplace_back(0.0f);
+	rate.emplace_back(duration > 0.0f ? 1.0f / duration : 1e30f);
+}
+
+//sin(x) for x in [0,pi], as cos(x - pi/2) by an even polynomial (max error ~5e-7),
+// so the batched loop has no calls or comparisons and can be vectorized:
+static inline float sin_0_pi(float x) {
+	float z = x - 1.57079633f;
+	float z2 = z * z;
+	return 1.0f + z2 * (-1.0f / 2.0f + z2 * (1.0f / 24.0f + z2 * (-1.0f / 720.0f + z2 * (1.0f / 40320.0f + z2 * (-1.0f / 3628800.0f)))));
+}
+
+//The batched passes are free functions so that __restrict (which compilers honor on parameters)
+// tells them the arrays don't overlap; with no calls, branches, or aliasing in the loop bodies,
+// they auto-vectorize (e.g., clang -O2, MSVC /O2, gcc -O3).
+
+//advance fraction complete and compute slerp weights:
+static void advance(uint32_t count, float elapsed, float *__restrict t, float const *__restrict rate,
+	float const *__restrict omega, float const *__restrict inv_sin_omega, float *__restrict w0, float *__restrict w1) {
+	for (uint32_t i = 0; i < count; ++i) {
+		//(t may pass 1; finished tweens are written from 'to', not from these weights)
+		float ti = t[i] + elapsed * rate[i];
+		t[i] = ti;
+		w0[i] = sin_0_pi((1.0f - ti) * omega[i]) * inv_sin_omega[i];
+		w1[i] = sin_0_pi(ti * omega[i]) * inv_sin_omega[i];
+	}
+}
+
+//out = w0 * from + w1 * to, for one quaternion component:
+static void blend(uint32_t count, float const *__restrict w0, float const *__restrict w1,
+	float const *__restrict from, float const *__restrict to, float *__restrict out) {
+	for (uint32_t i = 0; i < count; ++i) {
+		out[i] = w0[i] * from[i] + w1[i] * to[i];
+	}
+}
+
+void Tweens::update(float elapsed, glm::quat *rotations) {
+	uint32_t count = uint32_t(cells.size());
+	if (count == 0) return;
+	w0.resize(count); w1.resize(count);
+	out_x.resize(count); out_y.resize(count); out_z.resize(count); out_w.resize(count);
+
+	advance(count, elapsed, t.data(), rate.data(), omega.data(), inv_sin_omega.data(), w0.data(), w1.data());
+	blend(count, w0.data(), w1.data(), from_x.data(), to_x.data(), out_x.data());
+	blend(count, w0.data(), w1.data(), from_y.data(), to_y.data(), out_y.data());
+	blend(count, w0.data(), w1.data(), from_z.data(), to_z.data(), out_z.data());
+	blend(count, w0.data(), w1.data(), from_w.data(), to_w.data(), out_w.data());
+
+	//write out and compact away finished tweens (which land exactly on 'to'):
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (t[i] >= 1.0f) {
+			rotations[cells[i]] = glm::quat(to_w[i], to_x[i], to_y[i], to_z[i]);
+			continue;
+		}
+		rotations[cells[i]] = glm::quat(out_w[i], out_x[i], out_y[i], out_z[i]);
+		if (kept != i) {
+			cells[kept] = cells[i];
+			from_x[kept] = from_x[i]; from_y[kept] = from_y[i]; from_z[kept] = from_z[i]; from_w[kept] = from_w[i];
+			to_x[kept] = to_x[i]; to_y[kept] = to_y[i]; to_z[kept] = to_z[i]; to_w[kept] = to_w[i];
+			omega[kept] = omega[i];
+			inv_sin_omega[kept] = inv_sin_omega[i];
+			t[kept] = t[i];
+			rate[kept] = rate[i];
+		}
+		++kept;
+	}
+	if (kept != count) {
+		for (auto *v : {&from_x, &from_y, &from_z, &from_w, &to_x, &to_y, &to_z, &to_w, &omega, &inv_sin_omega, &t, &rate}) {
+			v->resize(kept);
+		}
+		cells.resize(kept);
+	}
+}
+
+void Tweens::clear() {
+	cells.clear();
+	for (auto *v : {&from_x, &from_y, &from_z, &from_w, &to_x, &to_y, &to_z, &to_w, &omega, &inv_sin_omega, &t, &rate}) {
+		v->clear();
+	}
+}
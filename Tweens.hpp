@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdint>
+
+//Tweens animates cell rotations from a start to an end orientation (by slerp).
+//
+//Active tweens are stored as structure-of-arrays, and update() advances all of them in one
+// pass over contiguous floats (no per-tween branches or pointer chasing), then writes the
+// results out and retires finished tweens by compacting the arrays. Slerp angles are
+// computed once in add(), so the per-frame work is two (polynomial) sines and a weighted
+// sum per tween.
+struct Tweens {
+	//animate rotations[cell] from 'from' to 'to' over 'duration' seconds:
+	void add(uint32_t cell, glm::quat const &from, glm::quat const &to, float duration);
+
+	//advance every tween by 'elapsed' seconds, write its rotation to rotations[cell],
+	// and retire tweens that have reached their end (which is written exactly):
+	void update(float elapsed, glm::quat *rotations);
+
+	void clear();
+	size_t size() const { return cells.size(); }
+
+	//------- active tweens (structure-of-arrays) -------
+
+	std::vector< uint32_t > cells;
+	std::vector< float > from_x, from_y, from_z, from_w;
+	std::vector< float > to_x, to_y, to_z, to_w;
+	std::vector< float > omega; //angle between from and to (at least 1e-3)
+	std::vector< float > inv_sin_omega; //1 / sin(omega)
+	std::vector< float > t; //fraction complete, in [0,1]
+	std::vector< float > rate; //1 / duration
+
+	//scratch output of the batched passes:
+	std::vector< float > w0, w1; //slerp weights
+	std::vector< float > out_x, out_y, out_z, out_w;
+};
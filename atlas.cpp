@@ -0,0 +1,267 @@
+//atlas packs the per-mesh textures of a meshes.blob (exported with --texcoords) into a few
+// large atlas textures, so the whole board samples one texture (or a few) instead of binding
+// a texture per mesh:
+// - every distinct texture is placed with MaxRects (largest first), in as many atlases of at
+//   most --max-size pixels as it takes, with --padding pixels of repeated edge around each
+//   (so mipmaps don't bleed between neighbors);
+// - untextured meshes get a small white patch in an atlas (so their vertex colors draw as
+//   before, without a texture of their own);
+// - texture coordinates are rewritten to point into the atlas (coordinates outside [0,1],
+//   i.e., textures meant to repeat, can't be atlased and are clamped, with a warning);
+// - the texture names point at the atlas files, and an "atl0" chunk records each mesh's
+//   rectangle in its atlas.
+//
+//Usage:
+//  atlas [--max-size N] [--padding P] in.blob out.blob
+//Textures are read from next to in.blob; atlases are written next to out.blob, named
+// after it (e.g., out-atlas0.png).
+
+#include "MaxRects.hpp"
+#include "load_save_png.hpp"
+#include "MeshVertices.hpp"
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t max_size = 4096;
+		uint32_t padding = 4;
+		std::string in;
+		std::string out;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--max-size" && has_value) {
+			config.max_size = std::max(16, std::atoi(argv[++argi]));
+		} else if (arg == "--padding" && has_value) {
+			config.padding = std::max(0, std::atoi(argv[++argi]));
+		} else if (arg.size() > 0 && arg[0] != '-' && config.in.empty()) {
+			config.in = arg;
+		} else if (arg.size() > 0 && arg[0] != '-' && config.out.empty()) {
+			config.out = arg;
+		} else {
+			config.out.clear();
+			break;
+		}
+	}
+	if (config.out.empty()) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--max-size N] [--padding P] in.blob out.blob" << std::endl;
+		return 1;
+	}
+
+	struct IndexEntry {
+		uint32_t name_begin;
+		uint32_t name_end;
+		uint32_t vertex_begin;
+		uint32_t vertex_end;
+	};
+	static_assert(sizeof(IndexEntry) == 16, "IndexEntry should be packed.");
+	struct TextureEntry {
+		uint32_t name_begin;
+		uint32_t name_end;
+	};
+	static_assert(sizeof(TextureEntry) == 8, "TextureEntry should be packed.");
+	struct AtlasEntry {
+		uint32_t x, y, width, height; //in atlas pixels (0 x 0 for untextured meshes)
+	};
+	static_assert(sizeof(AtlasEntry) == 16, "AtlasEntry should be packed.");
+
+	MeshVertices vertices; //(copied through as-is, palette and all)
+	std::vector< char > names;
+	std::vector< IndexEntry > index_entries;
+	std::vector< glm::vec2 > texcoords;
+	std::vector< TextureEntry > texture_entries;
+	{
+		std::ifstream blob(config.in, std::ios::binary);
+		if (!blob) {
+			std::cerr << "Failed to open '" << config.in << "'." << std::endl;
+			return 1;
+		}
+		vertices.read(blob);
+		read_chunk(blob, "str0", &names);
+		read_chunk(blob, "idx0", &index_entries);
+		if (blob.peek() == EOF) {
+			std::cerr << "'" << config.in << "' has no texture coordinates (export it with --texcoords)." << std::endl;
+			return 1;
+		}
+		read_chunk(blob, "tex0", &texcoords);
+		read_chunk(blob, "txr0", &texture_entries);
+		if (blob.peek() != EOF) {
+			std::cerr << "'" << config.in << "' has more chunks than expected (already an atlas?)." << std::endl;
+			return 1;
+		}
+		if (texcoords.size() != vertices.size() || texture_entries.size() != index_entries.size()) {
+			throw std::runtime_error("texture chunks do not match vertex and index chunks.");
+		}
+	}
+
+	auto directory = [](std::string const &path) {
+		return path.substr(0, path.find_last_of("/\\") + 1);
+	};
+
+	//distinct textures (name -> image), plus the white patch for untextured meshes (name ""):
+	struct Texture {
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > pixels;
+		uint32_t atlas = 0;
+		glm::uvec2 origin = glm::uvec2(0); //of the texture (not the padding) in the atlas
+	};
+	std::map< std::string, Texture > textures;
+	for (uint32_t i = 0; i < texture_entries.size(); ++i) {
+		TextureEntry const &e = texture_entries[i];
+		IndexEntry const &ie = index_entries[i];
+		if (e.name_begin > e.name_end || e.name_end > names.size() || ie.name_begin > ie.name_end || ie.name_end > names.size()) {
+			throw std::runtime_error("invalid name indices in index.");
+		}
+		if (ie.vertex_begin > ie.vertex_end || ie.vertex_end > vertices.size()) {
+			throw std::runtime_error("invalid vertex indices in index.");
+		}
+		std::string name(names.begin() + e.name_begin, names.begin() + e.name_end);
+		if (textures.count(name)) continue;
+		Texture &texture = textures[name];
+		if (name.empty()) {
+			texture.size = glm::uvec2(4);
+			texture.pixels.assign(16, glm::u8vec4(0xff));
+		} else {
+			load_png(directory(config.in) + name, &texture.size, &texture.pixels, LowerLeftOrigin);
+		}
+		if (texture.size.x + 2 * config.padding > config.max_size || texture.size.y + 2 * config.padding > config.max_size) {
+			std::cerr << "Texture '" << name << "' (" << texture.size.x << "x" << texture.size.y << ") does not fit in a " << config.max_size << "x" << config.max_size << " atlas." << std::endl;
+			return 1;
+		}
+	}
+	if (textures.size() == 1 && textures.count("")) {
+		std::cerr << "'" << config.in << "' has no textured meshes; nothing to pack." << std::endl;
+		return 1;
+	}
+
+	//pack, largest first (by longer side, then area):
+	std::vector< std::pair< std::string const, Texture > * > order;
+	for (auto &t : textures) order.emplace_back(&t);
+	std::stable_sort(order.begin(), order.end(), [](auto *a, auto *b){
+		glm::uvec2 sa = a->second.size, sb = b->second.size;
+		if (std::max(sa.x, sa.y) != std::max(sb.x, sb.y)) return std::max(sa.x, sa.y) > std::max(sb.x, sb.y);
+		return sa.x * sa.y > sb.x * sb.y;
+	});
+	std::vector< MaxRects > packers;
+	for (auto *t : order) {
+		Texture &texture = t->second;
+		glm::uvec2 padded = texture.size + glm::uvec2(2 * config.padding);
+		glm::uvec2 origin;
+		uint32_t a = 0;
+		while (a < packers.size() && !packers[a].insert(padded, &origin)) ++a;
+		if (a == packers.size()) {
+			packers.emplace_back(glm::uvec2(config.max_size));
+			if (!packers.back().insert(padded, &origin)) {
+				throw std::runtime_error("texture does not fit in an empty atlas.");
+			}
+		}
+		texture.atlas = a;
+		texture.origin = origin + glm::uvec2(config.padding);
+	}
+
+	//atlas sizes: the packed area, rounded up to powers of two (for full mip chains):
+	std::vector< glm::uvec2 > atlas_sizes;
+	for (MaxRects const &packer : packers) {
+		glm::uvec2 size(1);
+		while (size.x < packer.used.x) size.x *= 2;
+		while (size.y < packer.used.y) size.y *= 2;
+		atlas_sizes.emplace_back(size);
+	}
+
+	//draw textures (and padding, by clamping to each texture's edge) into atlases:
+	std::vector< std::vector< glm::u8vec4 > > atlases(packers.size());
+	for (uint32_t a = 0; a < atlases.size(); ++a) {
+		atlases[a].assign(atlas_sizes[a].x * atlas_sizes[a].y, glm::u8vec4(0));
+	}
+	for (auto const &t : textures) {
+		Texture const &texture = t.second;
+		std::vector< glm::u8vec4 > &atlas = atlases[texture.atlas];
+		glm::uvec2 atlas_size = atlas_sizes[texture.atlas];
+		int32_t pad = int32_t(config.padding);
+		for (int32_t y = -pad; y < int32_t(texture.size.y) + pad; ++y) {
+			int32_t sy = glm::clamp(y, 0, int32_t(texture.size.y) - 1);
+			for (int32_t x = -pad; x < int32_t(texture.size.x) + pad; ++x) {
+				int32_t sx = glm::clamp(x, 0, int32_t(texture.size.x) - 1);
+				atlas[(texture.origin.y + y) * atlas_size.x + (texture.origin.x + x)] = texture.pixels[sy * texture.size.x + sx];
+			}
+		}
+	}
+
+	//write atlases, and append their names to the strings:
+	std::string out_dir = directory(config.out);
+	std::string out_base = config.out.substr(out_dir.size());
+	std::string out_stem = out_base.substr(0, out_base.find_last_of('.'));
+	std::vector< TextureEntry > atlas_names;
+	for (uint32_t a = 0; a < atlases.size(); ++a) {
+		std::string name = out_stem + "-atlas" + std::to_string(a) + ".png";
+		save_png(out_dir + name, atlas_sizes[a], atlases[a].data(), LowerLeftOrigin);
+		TextureEntry entry;
+		entry.name_begin = uint32_t(names.size());
+		names.insert(names.end(), name.begin(), name.end());
+		entry.name_end = uint32_t(names.size());
+		atlas_names.emplace_back(entry);
+	}
+
+	//point meshes at their atlas rectangles:
+	std::vector< AtlasEntry > atlas_entries(index_entries.size());
+	for (uint32_t i = 0; i < index_entries.size(); ++i) {
+		IndexEntry const &ie = index_entries[i];
+		std::string texture_name(names.begin() + texture_entries[i].name_begin, names.begin() + texture_entries[i].name_end);
+		Texture const &texture = textures[texture_name];
+		glm::vec2 atlas_size = glm::vec2(atlas_sizes[texture.atlas]);
+
+		bool clamped = false;
+		for (uint32_t v = ie.vertex_begin; v < ie.vertex_end; ++v) {
+			glm::vec2 uv = texcoords[v];
+			if (texture_name.empty()) {
+				uv = glm::vec2(0.5f); //(center of the white patch)
+			} else if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f) {
+				uv = glm::clamp(uv, 0.0f, 1.0f);
+				clamped = true;
+			}
+			texcoords[v] = (glm::vec2(texture.origin) + uv * glm::vec2(texture.size)) / atlas_size;
+		}
+		if (clamped) {
+			std::cerr << "WARNING: mesh '" << std::string(names.begin() + ie.name_begin, names.begin() + ie.name_end)
+				<< "' has texture coordinates outside [0,1]; clamped them, so '" << texture_name << "' no longer repeats." << std::endl;
+		}
+
+		texture_entries[i] = atlas_names[texture.atlas];
+		if (!texture_name.empty()) {
+			atlas_entries[i] = AtlasEntry{texture.origin.x, texture.origin.y, texture.size.x, texture.size.y};
+		} else {
+			atlas_entries[i] = AtlasEntry{0, 0, 0, 0};
+		}
+	}
+
+	{
+		std::ofstream blob(config.out, std::ios::binary);
+		write_chunk_file_header(blob);
+		vertices.write(blob, ChunkAligned);
+		write_chunk(blob, "str0", names, ChunkAligned);
+		write_chunk(blob, "idx0", index_entries, ChunkAligned);
+		write_chunk(blob, "tex0", texcoords, ChunkAligned);
+		write_chunk(blob, "txr0", texture_entries, ChunkAligned);
+		write_chunk(blob, "atl0", atlas_entries, ChunkAligned);
+	}
+
+	std::cout << "Packed " << textures.size() - textures.count("") << " texture(s) into " << atlases.size() << " atlas(es):";
+	for (glm::uvec2 size : atlas_sizes) std::cout << " " << size.x << "x" << size.y;
+	std::cout << "\nWrote '" << config.out << "'." << std::endl;
+
+	return 0;
+}
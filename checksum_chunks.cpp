@@ -0,0 +1,98 @@
+//checksum_chunks adds CRC-32C trailers to every chunk of a chunk file (e.g., meshes.blob,
+// .bcn textures), so read_chunk verifies them as they load; or removes them, or checks a file.
+//
+//Usage:
+//  checksum_chunks [--strip] [--align] in out
+//  checksum_chunks --verify file [file ...]
+//The file must consist of chunks only (as written by write_chunk); 'in' and 'out' may be the same.
+//Files in the aligned layout (see chunk_header.hpp) stay aligned; --align converts older files to it.
+
+#include "MappedChunks.hpp"
+#include "write_chunk.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <stdexcept>
+
+struct Config {
+	bool strip = false;
+	bool align = false;
+	bool verify = false;
+	std::vector< std::string > files;
+};
+
+int main(int argc, char **argv) {
+	Config config;
+
+	bool usage = false;
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--strip") {
+			config.strip = true;
+		} else if (arg == "--align") {
+			config.align = true;
+		} else if (arg == "--verify") {
+			config.verify = true;
+		} else if (arg.size() > 0 && arg[0] != '-') {
+			config.files.emplace_back(arg);
+		} else {
+			usage = true;
+			break;
+		}
+	}
+	if (usage || (config.verify ? (config.strip || config.align || config.files.empty()) : config.files.size() != 2)) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--strip] [--align] in out\n"
+			<< "\t" << argv[0] << " --verify file [file ...]" << std::endl;
+		return 1;
+	}
+
+	try {
+		if (config.verify) {
+			for (std::string const &file : config.files) {
+				auto before = std::chrono::steady_clock::now();
+				MappedChunks chunks(file);
+				double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+				size_t bytes = 0, checksummed = 0;
+				for (MappedChunks::Chunk const &chunk : chunks.chunks) {
+					bytes += chunk.size;
+					checksummed += (chunk.checksummed ? 1 : 0);
+				}
+				std::cout << file << ": " << (chunks.version ? "aligned, " : "") << chunks.chunks.size() << " chunks ("
+					<< checksummed << " checksummed, all OK), " << bytes << " bytes in "
+					<< std::fixed << std::setprecision(1) << seconds * 1e3 << " ms." << std::endl;
+				std::cout.unsetf(std::ios::floatfield);
+			}
+		} else {
+			//(copy everything out before writing, in case 'in' and 'out' are the same file):
+			std::ostringstream buffer;
+			size_t count = 0;
+			bool align = config.align;
+			{
+				MappedChunks chunks(config.files[0]);
+				align = align || (chunks.version != 0);
+				uint32_t flags = (config.strip ? 0 : ChunkChecksum) | (align ? ChunkAligned : 0);
+				if (align) write_chunk_file_header(buffer);
+				for (MappedChunks::Chunk const &chunk : chunks.chunks) {
+					write_chunk(buffer, chunk.magic, std::vector< uint8_t >(chunk.data, chunk.data + chunk.size), flags);
+				}
+				count = chunks.chunks.size();
+			}
+			std::ofstream to(config.files[1], std::ios::binary);
+			if (!(to << buffer.str())) {
+				throw std::runtime_error("Failed to write '" + config.files[1] + "'.");
+			}
+			std::cout << (config.strip ? "Removed checksums from " : "Checksummed ") << count << " chunks"
+				<< (align ? " (aligned)" : "") << "; wrote '" << config.files[1] << "'." << std::endl;
+		}
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+//chunk_bench compares ways of loading a meshes.blob-like file with a large "dat0" chunk:
+// read_chunk into a new std::vector (which zeroes it first), into a reused caller-provided
+// buffer, into an Arena, and into an uninitialized array; then all of the file's chunks one
+// read_chunk at a time, with one large read (MappedChunks from a stream), and memory-mapped.
+//(A mapping does no work until its pages are used, so the mapped row sums every word of "dat0":
+// its time is the mapping, the page faults, and one pass over the data, against the copies above.)
+//
+//Usage:
+//  chunk_bench [--mb N] [--file path]
+//(N megabytes of vertex data, default 256; the file is written to 'path', default 'chunk_bench.tmp',
+// and read back while still in the page cache, so this measures the cost over the fastest possible disk)
+
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+#include "MappedChunks.hpp"
+#include "Arena.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+struct Config {
+	uint32_t mb = 256;
+	std::string file = "chunk_bench.tmp";
+};
+
+//same layout as a "dat0" vertex (see MeshVertices.hpp):
+struct Vertex {
+	float position[3];
+	float normal[3];
+	uint8_t color[4];
+};
+static_assert(sizeof(Vertex) == 28, "Vertex should be packed.");
+
+struct IndexEntry {
+	uint32_t name_begin, name_end, vertex_begin, vertex_end;
+};
+
+//best of a few runs, in seconds:
+template< typename F >
+static double best_time(F const &f) {
+	double best = 1e30;
+	for (uint32_t run = 0; run < 5; ++run) {
+		auto before = std::chrono::steady_clock::now();
+		f();
+		best = std::min(best, std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count());
+	}
+	return best;
+}
+
+int main(int argc, char **argv) {
+	Config config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--mb" && has_value) {
+			config.mb = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--file" && has_value) {
+			config.file = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--mb N] [--file path]" << std::endl;
+			return 1;
+		}
+	}
+
+	//write the test file:
+	std::vector< Vertex > vertices((size_t(config.mb) << 20) / sizeof(Vertex));
+	std::vector< char > names;
+	std::vector< IndexEntry > index;
+	for (size_t v = 0; v < vertices.size(); ++v) {
+		for (uint32_t i = 0; i < 3; ++i) {
+			vertices[v].position[i] = float(v % 1000) * 0.01f + i;
+			vertices[v].normal[i] = (i == 2 ? 1.0f : 0.0f);
+		}
+		for (uint32_t i = 0; i < 4; ++i) vertices[v].color[i] = uint8_t(v + i);
+	}
+	for (uint32_t m = 0; m < 1000; ++m) {
+		std::string name = "Mesh." + std::to_string(m);
+		IndexEntry entry;
+		entry.name_begin = uint32_t(names.size());
+		names.insert(names.end(), name.begin(), name.end());
+		entry.name_end = uint32_t(names.size());
+		entry.vertex_begin = uint32_t(vertices.size() * m / 1000);
+		entry.vertex_end = uint32_t(vertices.size() * (m + 1) / 1000);
+		index.emplace_back(entry);
+	}
+	{
+		std::ofstream out(config.file, std::ios::binary);
+		write_chunk_file_header(out);
+		write_chunk(out, "dat0", vertices, ChunkAligned);
+		write_chunk(out, "str0", names, ChunkAligned);
+		write_chunk(out, "idx0", index, ChunkAligned);
+		if (!out) {
+			std::cerr << "ERROR: failed to write '" << config.file << "'." << std::endl;
+			return 1;
+		}
+	}
+	size_t bytes = vertices.size() * sizeof(Vertex);
+
+	std::cout << "Reading " << vertices.size() << " vertices (" << config.mb << "MB) from '" << config.file << "':" << std::endl;
+	std::cout << std::fixed;
+	auto report = [&](char const *what, double seconds) {
+		std::cout << "  " << std::left << std::setw(38) << what << std::right
+			<< std::setprecision(2) << std::setw(8) << seconds * 1e3 << " ms "
+			<< std::setprecision(2) << std::setw(6) << bytes / seconds / 1e9 << " GB/s" << std::endl;
+	};
+	size_t check = 0; //(uses what was read, so reads can't be skipped)
+
+	//just the "dat0" chunk:
+	report("read_chunk, new std::vector", best_time([&](){
+		std::ifstream in(config.file, std::ios::binary);
+		std::vector< Vertex > to;
+		read_chunk(in, "dat0", &to);
+		check += to.back().color[0];
+	}));
+	{
+		std::vector< Vertex > buffer(vertices.size());
+		report("read_chunk, caller's buffer (reused)", best_time([&](){
+			std::ifstream in(config.file, std::ios::binary);
+			size_t count = read_chunk(in, "dat0", buffer.data(), buffer.size());
+			check += buffer[count - 1].color[0];
+		}));
+	}
+	report("read_chunk, new Arena", best_time([&](){
+		std::ifstream in(config.file, std::ios::binary);
+		Arena arena(bytes);
+		size_t count = 0;
+		Vertex const *to = read_chunk< Vertex >(in, "dat0", &arena, &count);
+		check += to[count - 1].color[0];
+	}));
+	report("read_chunk_uninitialized", best_time([&](){
+		std::ifstream in(config.file, std::ios::binary);
+		size_t count = 0;
+		std::unique_ptr< Vertex[] > to = read_chunk_uninitialized< Vertex >(in, "dat0", &count);
+		check += to[count - 1].color[0];
+	}));
+
+	//the whole file:
+	report("all chunks, read_chunk each", best_time([&](){
+		std::ifstream in(config.file, std::ios::binary);
+		std::vector< Vertex > to_vertices;
+		std::vector< char > to_names;
+		std::vector< IndexEntry > to_index;
+		read_chunk(in, "dat0", &to_vertices);
+		read_chunk(in, "str0", &to_names);
+		read_chunk(in, "idx0", &to_index);
+		check += to_vertices.back().color[0] + to_names.size() + to_index.size();
+	}));
+	report("all chunks, one read", best_time([&](){
+		std::ifstream in(config.file, std::ios::binary);
+		MappedChunks chunks(in);
+		size_t count = 0;
+		Vertex const *to = MappedChunks::data_as< Vertex >(*chunks.find("dat0"), &count);
+		check += to[count - 1].color[0] + chunks.chunks.size();
+	}));
+	report("all chunks, mapped in place (summed)", best_time([&](){
+		MappedChunks chunks(config.file);
+		size_t count = 0;
+		uint32_t const *words = MappedChunks::data_as< uint32_t >(*chunks.find("dat0"), &count);
+		uint32_t sum = 0;
+		for (size_t i = 0; i < count; ++i) sum += words[i];
+		check += sum + chunks.chunks.size();
+	}));
+
+	std::remove(config.file.c_str());
+
+	return (check == 1 ? 2 : 0); //(keeps the reads from being optimized out)
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdexcept>
+#include <cstdint>
+
+//Chunk files (meshes.blob, .bcn textures, puzzle sets, replays) are sequences of chunks, each
+// a ChunkHeader followed by 'size' bytes of data (see read_chunk.hpp, write_chunk.hpp).
+//
+//Files may also be written in an aligned layout (revision 1), made to be memory-mapped and
+// used in place (see MappedChunks.hpp):
+//  "chk1" chunk: one ChunkFileHeader
+//  then chunks as usual, except that each chunk's data starts at a multiple of
+//   ChunkAlignment bytes from the start of the file; "pad0" chunks fill the gaps.
+//read_chunk skips the file header and padding, so code reading chunks from a stream reads
+// both layouts the same.
+
+struct ChunkHeader {
+	char magic[4] = {'\0', '\0', '\0', '\0'};
+	uint32_t size = 0;
+};
+static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+
+//chunk headers whose size has this bit set are followed by a uint32_t CRC-32C of the chunk's data
+// (see crc32c.hpp; so chunk data is limited to 2GB):
+enum : uint32_t { ChunkChecksumBit = 0x80000000U };
+
+enum : uint32_t {
+	ChunkAlignment = 64, //cache line (and widest SIMD load)
+	ChunkByteOrder = 0x01020304U, //as written by the machine that wrote the file
+	ChunkFileVersion = 1,
+};
+
+struct ChunkFileHeader {
+	uint32_t byte_order = ChunkByteOrder;
+	uint32_t version = ChunkFileVersion;
+	uint32_t alignment = ChunkAlignment;
+	uint32_t reserved = 0;
+};
+static_assert(sizeof(ChunkFileHeader) == 16, "file header is packed");
+
+//throws if data described by 'header' can't be used as-is on this machine:
+inline void check_chunk_file_header(ChunkFileHeader const &header) {
+	if (header.byte_order != ChunkByteOrder) {
+		throw std::runtime_error("Chunk file was written with a different byte order.");
+	}
+	if (header.version != ChunkFileVersion) {
+		throw std::runtime_error("Chunk file has an unknown version.");
+	}
+	if (header.alignment == 0 || header.alignment > ChunkAlignment || (ChunkAlignment % header.alignment) != 0) {
+		throw std::runtime_error("Chunk file has an unsupported alignment.");
+	}
+}
+
+//size of the "pad0" chunk (header included) to write at file offset 'at' so that the next chunk's data is aligned:
+inline uint32_t chunk_padding(uint64_t at) {
+	uint32_t pad = uint32_t((ChunkAlignment - (at + sizeof(ChunkHeader)) % ChunkAlignment) % ChunkAlignment);
+	if (pad != 0 && pad < sizeof(ChunkHeader)) pad += ChunkAlignment;
+	return pad;
+}
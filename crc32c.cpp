@@ -0,0 +1,254 @@
+#include "crc32c.hpp"
+
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define CRC32C_X86 1
+#include <immintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2,pclmul")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CRC32C_X86 1
+#include <intrin.h>
+#define CRC32C_TARGET
+#endif
+
+//CRC-32C polynomial, bit-reflected (bit 0 is the coefficient of x^31):
+static constexpr uint32_t Poly = 0x82F63B78U;
+
+//------- portable (slice-by-8) -------
+
+namespace {
+struct Tables {
+	uint32_t t[8][256];
+	Tables() {
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t crc = n;
+			for (uint32_t k = 0; k < 8; ++k) {
+				crc = (crc & 1) ? (crc >> 1) ^ Poly : crc >> 1;
+			}
+			t[0][n] = crc;
+		}
+		for (uint32_t n = 0; n < 256; ++n) {
+			for (uint32_t k = 1; k < 8; ++k) {
+				t[k][n] = (t[k-1][n] >> 8) ^ t[0][t[k-1][n] & 0xff];
+			}
+		}
+	}
+};
+}
+
+static Tables const &tables() {
+	static Tables tables;
+	return tables;
+}
+
+//'crc' is the raw (already inverted) register:
+static uint32_t update_portable(uint32_t crc, uint8_t const *data, size_t size) {
+	auto const &t = tables().t;
+	while (size >= 8) {
+		uint64_t word;
+		std::memcpy(&word, data, 8); //(little-endian, as on every platform the game builds for)
+		word ^= crc;
+		crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff]
+		    ^ t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+		data += 8;
+		size -= 8;
+	}
+	while (size > 0) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xff];
+		++data;
+		--size;
+	}
+	return crc;
+}
+
+//------- SSE4.2 + PCLMULQDQ -------
+
+#if defined(CRC32C_X86)
+
+//a * b mod Poly (both bit-reflected):
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+	uint32_t m = 1U << 31, p = 0;
+	while (true) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0) break;
+		}
+		m >>= 1;
+		b = (b & 1) ? (b >> 1) ^ Poly : b >> 1;
+	}
+	return p;
+}
+
+//x^n mod Poly:
+static uint32_t xpow(uint64_t n) {
+	uint32_t result = 1U << 31; //x^0
+	uint32_t square = 1U << 30; //x^1
+	while (n) {
+		if (n & 1) result = multmodp(result, square);
+		square = multmodp(square, square);
+		n >>= 1;
+	}
+	return result;
+}
+
+//streams are processed in blocks of three; 'Long' blocks for big buffers, 'Short' for the rest:
+static constexpr size_t Long = 8192;
+static constexpr size_t Short = 256;
+
+namespace {
+//to advance a crc over n zero bytes, multiply it by x^(8n) -- done as a carry-less multiply by
+// x^(8n-33) followed by a crc32 instruction (which multiplies by x^32, with one more x from the
+// multiply's bit order) to reduce the product:
+struct Shifts {
+	uint32_t long1 = xpow(8 * Long - 33);
+	uint32_t long2 = xpow(8 * 2 * Long - 33);
+	uint32_t short1 = xpow(8 * Short - 33);
+	uint32_t short2 = xpow(8 * 2 * Short - 33);
+};
+}
+
+CRC32C_TARGET static inline uint32_t shift(uint32_t crc, uint32_t k) {
+	__m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(int(crc)), _mm_cvtsi32_si128(int(k)), 0);
+	return uint32_t(_mm_crc32_u64(0, uint64_t(_mm_cvtsi128_si64(product))));
+}
+
+CRC32C_TARGET static inline uint64_t load64(uint8_t const *at) {
+	uint64_t word;
+	std::memcpy(&word, at, 8);
+	return word;
+}
+
+//three streams of 'Block' bytes each (the crc32 instruction can start one every cycle, but each
+// takes three to finish, so one stream would leave it mostly idle):
+template< size_t Block >
+CRC32C_TARGET static inline uint32_t update_blocks(uint32_t crc, uint8_t const *&data, size_t &size, uint32_t k1, uint32_t k2) {
+	while (size >= 3 * Block) {
+		uint64_t c0 = crc, c1 = 0, c2 = 0;
+		for (size_t i = 0; i < Block; i += 8) {
+			c0 = _mm_crc32_u64(c0, load64(data + i));
+			c1 = _mm_crc32_u64(c1, load64(data + Block + i));
+			c2 = _mm_crc32_u64(c2, load64(data + 2 * Block + i));
+		}
+		crc = shift(uint32_t(c0), k2) ^ shift(uint32_t(c1), k1) ^ uint32_t(c2);
+		data += 3 * Block;
+		size -= 3 * Block;
+	}
+	return crc;
+}
+
+CRC32C_TARGET static uint32_t update_sse42(uint32_t crc, uint8_t const *data, size_t size) {
+	static Shifts const shifts;
+	while (size > 0 && (uintptr_t(data) & 7)) {
+		crc = _mm_crc32_u8(crc, *data);
+		++data;
+		--size;
+	}
+	crc = update_blocks< Long >(crc, data, size, shifts.long1, shifts.long2);
+	crc = update_blocks< Short >(crc, data, size, shifts.short1, shifts.short2);
+	uint64_t c = crc;
+	while (size >= 8) {
+		c = _mm_crc32_u64(c, load64(data));
+		data += 8;
+		size -= 8;
+	}
+	crc = uint32_t(c);
+	while (size > 0) {
+		crc = _mm_crc32_u8(crc, *data);
+		++data;
+		--size;
+	}
+	return crc;
+}
+
+static bool have_sse42() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) && (info[2] & (1 << 1)); //SSE4.2, PCLMULQDQ
+#else
+	return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+#endif
+}
+
+#endif //CRC32C_X86
+
+//------- interface -------
+
+typedef uint32_t (*Update)(uint32_t, uint8_t const *, size_t);
+
+static Update update() {
+#if defined(CRC32C_X86)
+	static Update const chosen = have_sse42() ? update_sse42 : update_portable;
+	return chosen;
+#else
+	return update_portable;
+#endif
+}
+
+uint32_t crc32c(void const *data, size_t size, uint32_t crc) {
+	return ~update()(~crc, static_cast< uint8_t const * >(data), size);
+}
+
+uint32_t crc32c_portable(void const *data, size_t size, uint32_t crc) {
+	return ~update_portable(~crc, static_cast< uint8_t const * >(data), size);
+}
+
+char const *crc32c_implementation() {
+	return (update() == update_portable ? "portable" : "sse4.2+pclmul");
+}
+
+uint32_t read_crc32c(std::istream &from, void *to_, size_t size) {
+	char *to = static_cast< char * >(to_);
+
+	//small reads (or single-core machines) aren't worth a thread; checksum each slice right after
+	// reading it, while it's still in cache:
+	constexpr size_t Slice = 1 << 20;
+	if (size <= 2 * Slice || std::thread::hardware_concurrency() < 2) {
+		uint32_t crc = 0;
+		for (size_t at = 0; at < size; at += Slice) {
+			size_t count = std::min(Slice, size - at);
+			if (!from.read(to + at, count)) {
+				throw std::runtime_error("Failed to read chunk data.");
+			}
+			crc = crc32c(to + at, count, crc);
+		}
+		return crc;
+	}
+
+	//read slice by slice, while another thread checksums the slices already read:
+	std::atomic< size_t > available(0);
+	std::atomic< bool > failed(false);
+	uint32_t crc = 0;
+	std::thread checksum([&](){
+		size_t done = 0;
+		while (done < size) {
+			size_t until = available.load(std::memory_order_acquire);
+			if (until == done) {
+				if (failed.load(std::memory_order_acquire)) return;
+				std::this_thread::yield();
+				continue;
+			}
+			crc = crc32c(to + done, until - done, crc);
+			done = until;
+		}
+	});
+
+	for (size_t at = 0; at < size; at += Slice) {
+		size_t count = std::min(Slice, size - at);
+		if (!from.read(to + at, count)) {
+			failed.store(true, std::memory_order_release);
+			break;
+		}
+		available.store(at + count, std::memory_order_release);
+	}
+	checksum.join();
+	if (failed) {
+		throw std::runtime_error("Failed to read chunk data.");
+	}
+	return crc;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+//crc32c computes CRC-32C (Castagnoli) checksums, as used by checksummed chunks (see chunk_header.hpp).
+//On x86-64 CPUs with SSE4.2 and PCLMULQDQ it uses the crc32 instruction on three independent
+// streams at once, stitched together with carry-less multiplies; elsewhere, a portable
+// table-driven version (slice-by-8) is used.
+
+//checksum of 'size' bytes at 'data'; pass a previous result as 'crc' to continue it
+// (i.e., crc32c(b, nb, crc32c(a, na)) == crc32c(a followed by b)):
+uint32_t crc32c(void const *data, size_t size, uint32_t crc = 0);
+//the same, but always with the portable code (for comparison):
+uint32_t crc32c_portable(void const *data, size_t size, uint32_t crc = 0);
+//which code crc32c() uses ("sse4.2+pclmul" or "portable"):
+char const *crc32c_implementation();
+
+//read 'size' bytes from 'from' into 'to', checksumming them as they arrive (on a second thread, for
+// large reads, so checksumming overlaps reading); returns the checksum, or throws if the read fails:
+uint32_t read_crc32c(std::istream &from, void *to, size_t size);
@@ -0,0 +1,115 @@
+//crc_bench measures CRC-32C (crc32c.*pp) throughput: the portable and accelerated checksums of
+// an in-memory buffer, then read_chunk of one large chunk stored with and without a checksum
+// (so the second is the whole cost of verification at load time).
+//
+//Usage:
+//  crc_bench [--mb N] [--file path]
+//(N megabytes of data, default 256; the chunks are written to 'path', default 'crc_bench.tmp',
+// and read back while still in the page cache, so this is the cost over the fastest possible disk)
+
+#include "crc32c.hpp"
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+struct Config {
+	uint32_t mb = 256;
+	std::string file = "crc_bench.tmp";
+};
+
+//best of a few runs, in GB/s:
+template< typename F >
+static double throughput(size_t bytes, F const &f) {
+	double best = 0.0;
+	for (uint32_t run = 0; run < 5; ++run) {
+		auto before = std::chrono::steady_clock::now();
+		f();
+		double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+		best = std::max(best, bytes / seconds / 1e9);
+	}
+	return best;
+}
+
+int main(int argc, char **argv) {
+	Config config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--mb" && has_value) {
+			config.mb = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--file" && has_value) {
+			config.file = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--mb N] [--file path]" << std::endl;
+			return 1;
+		}
+	}
+
+	size_t bytes = size_t(config.mb) << 20;
+	std::vector< uint8_t > data(bytes);
+	{
+		std::mt19937 mt(0x5eed);
+		for (auto &b : data) b = uint8_t(mt());
+	}
+
+	//check the accelerated code against a known value and the portable code:
+	{
+		char const *check = "123456789";
+		if (crc32c(check, 9) != 0xE3069283U || crc32c_portable(check, 9) != 0xE3069283U) {
+			std::cerr << "ERROR: wrong checksum for '123456789'." << std::endl;
+			return 1;
+		}
+		std::mt19937 mt(1);
+		for (uint32_t i = 0; i < 1000; ++i) {
+			size_t begin = mt() % 64;
+			size_t size = mt() % (1 << (mt() % 18));
+			size = std::min(size, data.size() - begin);
+			if (crc32c(data.data() + begin, size) != crc32c_portable(data.data() + begin, size)) {
+				std::cerr << "ERROR: accelerated and portable checksums differ (" << size << " bytes at offset " << begin << ")." << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	std::cout << "crc32c using '" << crc32c_implementation() << "' code; " << config.mb << "MB of data." << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	uint32_t sink = 0;
+	std::cout << "  portable checksum:    " << std::setw(6) << throughput(bytes, [&](){ sink ^= crc32c_portable(data.data(), data.size()); }) << " GB/s" << std::endl;
+	std::cout << "  crc32c checksum:      " << std::setw(6) << throughput(bytes, [&](){ sink ^= crc32c(data.data(), data.size()); }) << " GB/s" << std::endl;
+
+	for (bool checksum : {false, true}) {
+		{
+			std::ofstream out(config.file, std::ios::binary);
+			write_chunk(out, "test", data, checksum ? ChunkChecksum : 0);
+			if (!out) {
+				std::cerr << "ERROR: failed to write '" << config.file << "'." << std::endl;
+				return 1;
+			}
+		}
+		std::vector< uint8_t > loaded;
+		double gbps = throughput(bytes, [&](){
+			std::ifstream in(config.file, std::ios::binary);
+			read_chunk(in, "test", &loaded);
+		});
+		if (loaded != data) {
+			std::cerr << "ERROR: chunk did not read back correctly." << std::endl;
+			return 1;
+		}
+		std::cout << "  read_chunk " << (checksum ? "(verified):" : "(plain):   ") << " " << std::setw(6) << gbps << " GB/s" << std::endl;
+	}
+	std::remove(config.file.c_str());
+
+	return (sink == 0x12345678U ? 2 : 0); //(keeps the checksums from being optimized out)
+}
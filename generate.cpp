@@ -0,0 +1,156 @@
+//generate makes a PuzzleSet of discrete-mode puzzles: each is a solved board scrambled
+// by a random roll sequence, rated by the length of its shortest solution (see Solver.hpp).
+//
+//Usage:
+//  generate [--size WxH] [--count N] [--scramble K] [--seed S] [--threads T] [--max-depth D] [--out puzzles.set]
+//Puzzle i depends only on (seed, i), so output does not depend on the thread count.
+//Scrambles that cancel back to the solved board are retried with the next sub-seed.
+//Play a generated puzzle with 'main --puzzles puzzles.set --puzzle i'.
+
+#include "PuzzleSet.hpp"
+#include "Solver.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+
+int main(int argc, char **argv) {
+	struct {
+		glm::uvec2 board_size = glm::uvec2(5,4);
+		uint32_t count = 10000;
+		uint32_t scramble = 6;
+		uint32_t seed = 1;
+		uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+		uint32_t max_depth = 8;
+		std::string out = "puzzles.set";
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--size" && has_value) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++argi], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "Expecting --size WxH." << std::endl;
+				return 1;
+			}
+			config.board_size = glm::uvec2(w,h);
+		} else if (arg == "--count" && has_value) {
+			config.count = std::atoi(argv[++argi]);
+		} else if (arg == "--scramble" && has_value) {
+			config.scramble = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--seed" && has_value) {
+			config.seed = std::atoi(argv[++argi]);
+		} else if (arg == "--threads" && has_value) {
+			config.threads = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--max-depth" && has_value) {
+			config.max_depth = std::atoi(argv[++argi]);
+		} else if (arg == "--out" && has_value) {
+			config.out = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--size WxH] [--count N] [--scramble K] [--seed S] [--threads T] [--max-depth D] [--out puzzles.set]" << std::endl;
+			return 1;
+		}
+	}
+
+	uint32_t cells = config.board_size.x * config.board_size.y;
+	std::vector< uint8_t > goal(cells, CubeRotations::Identity);
+
+	//results, indexed by puzzle (filled in by whichever thread takes each index):
+	std::vector< PuzzleSet::Info > infos(config.count);
+	std::vector< std::vector< uint8_t > > boards(config.count);
+
+	std::atomic< uint32_t > next_puzzle(0);
+	auto worker = [&]() {
+		//one single-threaded solver per worker; puzzles are the unit of parallelism:
+		Solver::Options options;
+		options.threads = 1;
+		options.max_depth = config.max_depth;
+		options.table_bits = 16;
+		Solver solver(config.board_size, options);
+
+		while (true) {
+			uint32_t index = next_puzzle.fetch_add(1);
+			if (index >= config.count) break;
+
+			for (uint32_t attempt = 0; ; ++attempt) {
+				std::mt19937 mt(config.seed * 0x9e3779b9U + index * 0x85ebca6bU + attempt);
+				std::vector< uint8_t > board = goal;
+				for (uint32_t s = 0; s < config.scramble; ++s) {
+					Solver::Move move;
+					move.x = uint16_t(mt() % config.board_size.x);
+					move.y = uint16_t(mt() % config.board_size.y);
+					move.roll = CubeRotations::Roll(mt() % CubeRotations::RollCount);
+					Solver::apply(&board, config.board_size, move);
+				}
+				if (board == goal) continue;
+
+				Solver::Result result = solver.solve(board, goal);
+				PuzzleSet::Info &info = infos[index];
+				info.seed = mt();
+				info.nodes = uint32_t(std::min< uint64_t >(result.nodes, 0xffffffffU));
+				if (result.solved) {
+					info.moves = uint8_t(result.moves.size());
+				} else {
+					//(every bound up to max_depth either was searched or is below the root heuristic):
+					uint32_t at_least = std::max(result.lower_bound, std::min(config.max_depth, 255U) + 1);
+					info.moves = uint8_t(std::min(at_least, 255U));
+					info.flags |= PuzzleSet::LowerBound;
+				}
+				boards[index] = board;
+				break;
+			}
+		}
+	};
+
+	auto before = std::chrono::steady_clock::now();
+	std::vector< std::thread > threads;
+	for (uint32_t t = 0; t < config.threads; ++t) {
+		threads.emplace_back(worker);
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+
+	PuzzleSet set(config.board_size);
+	for (uint32_t i = 0; i < config.count; ++i) {
+		set.add(infos[i], boards[i]);
+	}
+	set.save(config.out);
+
+	std::cout << "Generated " << config.count << " " << config.board_size.x << "x" << config.board_size.y << " puzzles with "
+		<< config.threads << " thread(s) in " << std::fixed << std::setprecision(3) << seconds << " s = "
+		<< std::setprecision(0) << (seconds > 0.0 ? config.count / seconds : 0.0) << " puzzles/second." << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << "Wrote '" << config.out << "' (" << set.packed.size() + set.infos.size() * sizeof(PuzzleSet::Info) << " bytes of puzzle data)." << std::endl;
+
+	//difficulty histogram:
+	std::vector< uint32_t > by_moves;
+	uint32_t unsolved = 0;
+	for (auto const &info : infos) {
+		if (info.flags & PuzzleSet::LowerBound) {
+			unsolved += 1;
+		} else {
+			if (info.moves >= by_moves.size()) by_moves.resize(info.moves + 1, 0);
+			by_moves[info.moves] += 1;
+		}
+	}
+	for (uint32_t m = 0; m < by_moves.size(); ++m) {
+		if (by_moves[m]) std::cout << "  " << std::setw(3) << m << " moves: " << by_moves[m] << "\n";
+	}
+	if (unsolved) std::cout << "  >" << config.max_depth << " moves: " << unsolved << "\n";
+	std::cout.flush();
+
+	return 0;
+}
@@ -299,6 +299,7 @@ DO(CLEARBUFFERIV, ClearBufferiv)
 DO(CLEARBUFFERUIV, ClearBufferuiv)
 DO(CLEARBUFFERFV, ClearBufferfv)
 DO(CLEARBUFFERFI, ClearBufferfi)
+DO(GETSTRINGI, GetStringi)
 DO(ISRENDERBUFFER, IsRenderbuffer)
 DO(BINDRENDERBUFFER, BindRenderbuffer)
 DO(DELETERENDERBUFFERS, DeleteRenderbuffers)
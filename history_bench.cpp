@@ -0,0 +1,108 @@
+//history_bench measures History (undo/redo) memory and rewind cost:
+// performs N random rolls on boards of several sizes, then undoes up to U of them
+// (checking the board hash after each undo against the hash recorded at that point)
+// and redoes them again.
+//
+//Usage:
+//  history_bench [--actions N] [--undos U] [--keyframe-interval K]
+//(--keyframe-interval 0, the default, lets History pick one per board size)
+
+#include "History.hpp"
+#include "BoardSim.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t actions = 10000;
+		uint32_t undos = 1000;
+		uint32_t keyframe_interval = 0;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--actions" && has_value) {
+			config.actions = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--undos" && has_value) {
+			config.undos = std::atoi(argv[++argi]);
+		} else if (arg == "--keyframe-interval" && has_value) {
+			config.keyframe_interval = std::atoi(argv[++argi]);
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--actions N] [--undos U] [--keyframe-interval K]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector< glm::uvec2 > sizes{ glm::uvec2(5,4), glm::uvec2(64,64), glm::uvec2(512,512) };
+	bool ok = true;
+
+	std::cout << "Memory for " << config.actions << " actions; 'naive' is one full board snapshot per action." << std::endl;
+	std::cout << "    board       mode | interval | history bytes | naive bytes |  undo avg   undo max" << std::endl;
+	for (auto size : sizes) {
+		for (bool discrete : {true, false}) {
+			BoardSim sim;
+			sim.reset(size, 0xbead1234, discrete);
+			History history(config.actions, config.keyframe_interval);
+			history.reset(sim);
+			std::vector< uint64_t > hashes; //hashes[i] is the board hash after i actions
+			hashes.emplace_back(sim.state_hash);
+
+			std::mt19937 mt(1);
+			for (uint32_t a = 0; a < config.actions; ++a) {
+				BoardSim::RollAction action;
+				action.cursor_x = uint32_t(mt() % size.x);
+				action.cursor_y = uint32_t(mt() % size.y);
+				if (discrete) {
+					action.roll = CubeRotations::Roll(mt() % CubeRotations::RollCount);
+				} else {
+					action.controls = uint8_t(1 << (mt() % 4));
+					action.angle = 0.1f;
+				}
+				sim.apply_action(action);
+				history.record(sim, action);
+				history.record(sim, BoardSim::RollAction()); //key released: next roll is a new action
+				hashes.emplace_back(sim.state_hash);
+			}
+			size_t bytes = history.memory_bytes();
+
+			bool hashes_ok = true;
+			double undo_total = 0.0, undo_max = 0.0;
+			uint32_t undone = 0;
+			while (undone < config.undos) {
+				auto before = std::chrono::steady_clock::now();
+				bool did = history.undo(&sim);
+				double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+				if (!did) break;
+				undo_total += seconds;
+				undo_max = std::max(undo_max, seconds);
+				undone += 1;
+				if (sim.state_hash != hashes[config.actions - undone]) hashes_ok = false;
+			}
+			while (history.redo(&sim)) { }
+			if (sim.state_hash != hashes.back()) hashes_ok = false;
+			if (!hashes_ok) ok = false;
+
+			size_t state_bytes = size.x * size.y * (discrete ? sizeof(uint8_t) : sizeof(glm::quat));
+			std::cout << std::setw(5) << size.x << "x" << std::setw(4) << std::left << size.y << std::right
+				<< std::setw(11) << (discrete ? "discrete" : "continuous") << " | "
+				<< std::setw(8) << history.keyframe_interval << " | "
+				<< std::setw(13) << bytes << " | "
+				<< std::setw(11) << state_bytes * config.actions << " | "
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(7) << (undone ? undo_total / undone * 1e6 : 0.0) << "us "
+				<< std::setw(7) << undo_max * 1e6 << "us"
+				<< (hashes_ok ? "" : "  HASH MISMATCH") << std::endl;
+			std::cout.unsetf(std::ios::floatfield);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+//hugepage_bench measures what huge pages do for a large (row-major) board: time and data-TLB
+// misses per cell for column rolls, row rolls, and building a draw list in 64x64-cell chunks,
+// with the board's rotations in regular, transparent huge, and hugetlbfs pages (HugePages).
+//
+//Usage:
+//  hugepage_bench [--size N] [--rolls R]
+//(board is N x N; default 8192, i.e., 1GB of rotations)
+//TLB misses are read from perf counters (Linux, where permitted; otherwise shown as '-').
+//hugetlbfs pages must be reserved first (e.g., 'sysctl vm.nr_hugepages=600' for the default size),
+// otherwise that row falls back to another kind of page (shown in the 'pages' column).
+
+#include "HugePages.hpp"
+#include "CellLayout.hpp"
+#include "BoardSim.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+//counts data-TLB read misses of this thread, if perf events are available:
+struct TlbCounter {
+	TlbCounter() {
+#if defined(__linux__)
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~TlbCounter() {
+#if defined(__linux__)
+		if (fd >= 0) close(fd);
+#endif
+	}
+	void start() {
+#if defined(__linux__)
+		if (fd < 0) return;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+	//misses since start(), or -1 if unavailable:
+	int64_t stop() {
+#if defined(__linux__)
+		if (fd < 0) return -1;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t count = 0;
+		if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+		return int64_t(count);
+#else
+		return -1;
+#endif
+	}
+	int fd = -1;
+};
+
+//kilobytes of this process's anonymous memory in transparent huge pages (0 if unknown):
+static uint64_t anon_huge_kb() {
+	std::ifstream smaps("/proc/self/smaps_rollup");
+	std::string line;
+	while (std::getline(smaps, line)) {
+		if (line.compare(0, 14, "AnonHugePages:") == 0) return std::strtoull(line.c_str() + 14, nullptr, 10);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t size = 8192;
+		uint32_t rolls = 2000;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--size" && has_value) {
+			config.size = std::max(64, std::atoi(argv[++argi]));
+		} else if (arg == "--rolls" && has_value) {
+			config.rolls = std::max(1, std::atoi(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--size N] [--rolls R]" << std::endl;
+			return 1;
+		}
+	}
+
+	uint32_t const size = config.size;
+	CellLayout const layout(CellLayout::RowMajor, glm::uvec2(size, size));
+	glm::quat const dr = BoardSim::roll_rotation(BoardSim::controls_from_bits(BoardSim::TickInput::RollUp), 0.01f);
+	uint32_t const DrawChunk = 64;
+	TlbCounter tlb;
+	float checksum = 0.0f; //keeps the draw list from being optimized away
+
+	std::cout << size << "x" << size << " board, " << (uint64_t(size) * size * sizeof(glm::quat) >> 20) << " MB of rotations." << std::endl;
+	std::cout << "  requested  pages        huge MB | column roll       row roll          draw list   (ns / dTLB misses per cell)" << std::endl;
+	for (HugePages::Policy policy : {HugePages::Off, HugePages::Transparent, HugePages::Explicit}) {
+		uint64_t huge_before = anon_huge_kb();
+		HugePages::Block block(uint64_t(size) * size * sizeof(glm::quat), policy);
+		glm::quat *rotations = reinterpret_cast< glm::quat * >(block.data);
+		std::fill(rotations, rotations + uint64_t(size) * size, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		uint64_t huge_mb = (block.source == HugePages::ExplicitPages ? block.bytes >> 20 : (anon_huge_kb() - huge_before) >> 10);
+
+		struct Result { double ns = 0.0; double misses = -1.0; };
+		auto measure = [&](uint64_t cells, auto const &work) {
+			Result result;
+			tlb.start();
+			auto before = std::chrono::steady_clock::now();
+			work();
+			double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+			int64_t misses = tlb.stop();
+			result.ns = seconds / cells * 1e9;
+			if (misses >= 0) result.misses = double(misses) / cells;
+			return result;
+		};
+
+		std::mt19937 mt(1);
+		Result column = measure(uint64_t(config.rolls) * size, [&](){
+			for (uint32_t r = 0; r < config.rolls; ++r) {
+				layout.for_column(mt() % size, [&](uint32_t, uint32_t i){
+					rotations[i] = glm::normalize(dr * rotations[i]);
+				});
+			}
+		});
+		Result row = measure(uint64_t(config.rolls) * size, [&](){
+			for (uint32_t r = 0; r < config.rolls; ++r) {
+				layout.for_row(mt() % size, [&](uint32_t, uint32_t i){
+					rotations[i] = glm::normalize(dr * rotations[i]);
+				});
+			}
+		});
+		Result draw = measure(uint64_t(size) * size, [&](){
+			std::vector< glm::mat4 > draw_list;
+			draw_list.reserve(DrawChunk * DrawChunk);
+			for (uint32_t y0 = 0; y0 < size; y0 += DrawChunk) {
+				for (uint32_t x0 = 0; x0 < size; x0 += DrawChunk) {
+					draw_list.clear();
+					for (uint32_t y = y0; y < std::min(y0 + DrawChunk, size); ++y) {
+						for (uint32_t x = x0; x < std::min(x0 + DrawChunk, size); ++x) {
+							glm::mat4 m = glm::mat4_cast(rotations[layout.index(x, y)]);
+							m[3] = glm::vec4(x + 0.5f, y + 0.5f, 0.0f, 1.0f);
+							draw_list.emplace_back(m);
+						}
+					}
+					checksum += draw_list.back()[0][0];
+				}
+			}
+		});
+
+		auto show = [](Result const &r) {
+			std::ostringstream str;
+			str << std::fixed << std::setprecision(2) << std::setw(7) << r.ns << " / ";
+			if (r.misses < 0.0) str << std::setw(5) << "-";
+			else str << std::setprecision(3) << std::setw(5) << r.misses;
+			return str.str();
+		};
+		char const *requested = (policy == HugePages::Off ? "off" : policy == HugePages::Transparent ? "thp" : "hugetlb");
+		std::cout << "  " << std::setw(9) << requested << "  " << std::left << std::setw(11) << HugePages::name(block.source) << std::right
+			<< std::setw(8) << huge_mb << " | " << show(column) << "   " << show(row) << "   " << show(draw) << std::endl;
+	}
+	if (checksum == 12345.0f) std::cout << "(unlikely checksum)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+//layout_bench compares CellLayout::RowMajor and CellLayout::Tiled on square boards from
+// 64x64 to 8192x8192: the cost per cell of rolling random rows, rolling random columns,
+// and building a draw list (a matrix per cell) in 64x64-cell screen chunks.
+//
+//Usage:
+//  layout_bench [--max-size N] [--cells C]
+//(each roll test touches about C cells in total; default 4M)
+
+#include "CellLayout.hpp"
+#include "BoardSim.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t max_size = 8192;
+		uint32_t cells = 1 << 22;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--max-size" && has_value) {
+			config.max_size = std::max(64, std::atoi(argv[++argi]));
+		} else if (arg == "--cells" && has_value) {
+			config.cells = std::max(1, std::atoi(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--max-size N] [--cells C]" << std::endl;
+			return 1;
+		}
+	}
+
+	glm::quat const dr = BoardSim::roll_rotation(BoardSim::controls_from_bits(BoardSim::TickInput::RollUp), 0.01f);
+	uint32_t const DrawChunk = 64;
+	float checksum = 0.0f; //keeps the draw list from being optimized away
+
+	std::cout << "  board      layout | row roll   column roll   draw list   (ns per cell)" << std::endl;
+	for (uint32_t size = 64; size <= config.max_size; size *= 2) {
+		for (CellLayout::Kind kind : {CellLayout::RowMajor, CellLayout::Tiled}) {
+			CellLayout layout(kind, glm::uvec2(size, size));
+			std::vector< glm::quat > rotations(layout.storage_cells(), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+			uint32_t rolls = std::max(16U, config.cells / size);
+
+			auto time_per_cell = [](std::chrono::steady_clock::time_point before, uint64_t cells) {
+				return std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count() / cells * 1e9;
+			};
+
+			std::mt19937 mt(1);
+			auto before = std::chrono::steady_clock::now();
+			for (uint32_t r = 0; r < rolls; ++r) {
+				layout.for_row(mt() % size, [&](uint32_t, uint32_t i){
+					rotations[i] = glm::normalize(dr * rotations[i]);
+				});
+			}
+			double row_ns = time_per_cell(before, uint64_t(rolls) * size);
+
+			before = std::chrono::steady_clock::now();
+			for (uint32_t r = 0; r < rolls; ++r) {
+				layout.for_column(mt() % size, [&](uint32_t, uint32_t i){
+					rotations[i] = glm::normalize(dr * rotations[i]);
+				});
+			}
+			double column_ns = time_per_cell(before, uint64_t(rolls) * size);
+
+			//draw list: visit the board in screen chunks, emitting a matrix per cell:
+			std::vector< glm::mat4 > draw_list;
+			draw_list.reserve(DrawChunk * DrawChunk);
+			before = std::chrono::steady_clock::now();
+			for (uint32_t y0 = 0; y0 < size; y0 += DrawChunk) {
+				for (uint32_t x0 = 0; x0 < size; x0 += DrawChunk) {
+					draw_list.clear();
+					for (uint32_t y = y0; y < std::min(y0 + DrawChunk, size); ++y) {
+						for (uint32_t x = x0; x < std::min(x0 + DrawChunk, size); ++x) {
+							glm::mat4 m = glm::mat4_cast(rotations[layout.index(x, y)]);
+							m[3] = glm::vec4(x + 0.5f, y + 0.5f, 0.0f, 1.0f);
+							draw_list.emplace_back(m);
+						}
+					}
+					checksum += draw_list.back()[0][0];
+				}
+			}
+			double draw_ns = time_per_cell(before, uint64_t(size) * size);
+
+			std::cout << std::setw(5) << size << "x" << std::setw(5) << std::left << size << std::right
+				<< std::setw(8) << (kind == CellLayout::Tiled ? "tiled" : "row") << " | "
+				<< std::fixed << std::setprecision(2) << std::setw(8) << row_ns << "   " << std::setw(11) << column_ns
+				<< "   " << std::setw(9) << draw_ns << std::endl;
+			std::cout.unsetf(std::ios::floatfield);
+		}
+	}
+	if (checksum == 12345.0f) std::cout << "(unlikely checksum)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "load_save_png.hpp"
+
+#include <png.h>
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+//libpng reports errors by longjmp-ing back to the setjmp in each function below;
+// only plain data (no destructors) may be live between setjmp and the libpng calls.
+
+void load_png(std::string const &filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
+	std::unique_ptr< FILE, int(*)(FILE *) > file(std::fopen(filename.c_str(), "rb"), &std::fclose);
+	if (!file) {
+		throw std::runtime_error("Failed to open PNG '" + filename + "'.");
+	}
+
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!png) {
+		throw std::runtime_error("Failed to create PNG read struct.");
+	}
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_read_struct(&png, nullptr, nullptr);
+		throw std::runtime_error("Failed to create PNG info struct.");
+	}
+
+	std::vector< png_bytep > rows;
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, &info, nullptr);
+		throw std::runtime_error("Failed to read PNG '" + filename + "'.");
+	}
+
+	png_init_io(png, file.get());
+	png_read_info(png, info);
+
+	//convert whatever is in the file to 8-bit RGBA:
+	png_byte color_type = png_get_color_type(png, info);
+	png_byte bit_depth = png_get_bit_depth(png, info);
+	if (bit_depth == 16) png_set_strip_16(png);
+	if (color_type == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) png_set_expand_gray_1_2_4_to_8(png);
+	if (png_get_valid(png, info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png);
+	if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_PALETTE) {
+		png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+	}
+	if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
+	png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+
+	*size = glm::uvec2(png_get_image_width(png, info), png_get_image_height(png, info));
+	if (png_get_rowbytes(png, info) != size->x * sizeof(glm::u8vec4)) {
+		png_destroy_read_struct(&png, &info, nullptr);
+		throw std::runtime_error("PNG '" + filename + "' did not convert to RGBA8.");
+	}
+
+	data->resize(size->x * size->y);
+	rows.resize(size->y);
+	for (uint32_t y = 0; y < size->y; ++y) {
+		uint32_t row = (origin == UpperLeftOrigin ? y : size->y - 1 - y);
+		rows[y] = reinterpret_cast< png_bytep >(data->data() + row * size->x);
+	}
+	png_read_image(png, rows.data());
+	png_read_end(png, nullptr);
+
+	png_destroy_read_struct(&png, &info, nullptr);
+}
+
+void save_png(std::string const &filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
+	std::unique_ptr< FILE, int(*)(FILE *) > file(std::fopen(filename.c_str(), "wb"), &std::fclose);
+	if (!file) {
+		throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+	}
+
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!png) {
+		throw std::runtime_error("Failed to create PNG write struct.");
+	}
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_write_struct(&png, nullptr);
+		throw std::runtime_error("Failed to create PNG info struct.");
+	}
+
+	std::vector< png_bytep > rows(size.y);
+	for (uint32_t y = 0; y < size.y; ++y) {
+		uint32_t row = (origin == UpperLeftOrigin ? y : size.y - 1 - y);
+		rows[y] = reinterpret_cast< png_bytep >(const_cast< glm::u8vec4 * >(data + row * size.x));
+	}
+
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_write_struct(&png, &info);
+		throw std::runtime_error("Failed to write PNG '" + filename + "'.");
+	}
+
+	png_init_io(png, file.get());
+	png_set_IHDR(png, info, size.x, size.y, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+		PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+	png_write_image(png, rows.data());
+	png_write_end(png, nullptr);
+
+	png_destroy_write_struct(&png, &info);
+
+	if (std::fflush(file.get()) != 0) {
+		throw std::runtime_error("Failed to write PNG '" + filename + "'.");
+	}
+}
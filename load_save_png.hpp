@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+//PNG reading and writing (via libpng), as RGBA8 pixels.
+//
+//Pixel rows may be stored bottom row first (as OpenGL textures expect) or top row first
+// (as images are usually stored, and as SoftRenderer writes them):
+enum OriginLocation {
+	LowerLeftOrigin,
+	UpperLeftOrigin,
+};
+
+//NOTE: both throw on failure.
+//load_png converts any PNG (gray, palette, 16-bit, ...) to RGBA8:
+void load_png(std::string const &filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
+void save_png(std::string const &filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
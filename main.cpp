@@ -1,6 +1,12 @@
 //Game.hpp declares the "game" object, which handles game-specific stuff:
 #include "Game.hpp"
 
+//startup_trace times each phase of startup:
+#include "startup_trace.hpp"
+
+//PuzzleSet holds generated puzzles (see generate.cpp):
+#include "PuzzleSet.hpp"
+
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
@@ -19,18 +25,89 @@
 #include <fstream>
 #include <memory>
 #include <algorithm>
+#include <cstdlib>
+#include <cstdio>
 
 int main(int argc, char **argv) {
 	struct {
 		//TODO: this is where you set the title and size of your game window
 		std::string title = "TODO: Game Title";
 		glm::uvec2 size = glm::uvec2(640, 400);
+		//if non-empty, print startup phase timings and write them to this file:
+		std::string startup_trace;
+		//if non-empty, record per-tick input to this file (for replay in 'server'):
+		std::string record;
+		//if non-empty, show boards published to this shared memory ring instead of playing:
+		std::string view;
+		//if true, rolls are quarter turns (see BoardSim::discrete):
+		bool discrete = false;
+		//if non-empty, play puzzle 'puzzle' from this PuzzleSet (written by 'generate'; implies discrete):
+		std::string puzzles;
+		uint32_t puzzle = 0;
+		//if nonzero, play on a board of this size (rather than Game's default):
+		glm::uvec2 board = glm::uvec2(0,0);
+		//if true, store rotations sparsely (see SparseRotations; continuous mode only):
+		bool sparse = false;
 	} config;
 
+	//------------  command line arguments ------------
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--startup-trace" && argi + 1 < argc) {
+			config.startup_trace = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--record" && argi + 1 < argc) {
+			config.record = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--discrete") {
+			config.discrete = true;
+		} else if (arg == "--sparse") {
+			config.sparse = true;
+		} else if (arg == "--board" && argi + 1 < argc) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[argi+1], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "Expecting --board WxH." << std::endl;
+				return 1;
+			}
+			config.board = glm::uvec2(w, h);
+			argi += 1;
+		} else if (arg == "--view" && argi + 1 < argc) {
+			config.view = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--puzzles" && argi + 1 < argc) {
+			config.puzzles = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--puzzle" && argi + 1 < argc) {
+			config.puzzle = std::atoi(argv[argi+1]);
+			argi += 1;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--startup-trace <trace.json>] [--record <inputs.replay>] [--view <name>] [--board WxH] [--discrete | --sparse] [--puzzles <puzzles.set> [--puzzle <index>]]" << std::endl;
+			return 1;
+		}
+	}
+	if (config.view != "" && (config.discrete || config.puzzles != "")) {
+		//published snapshots are continuous boards:
+		std::cerr << "--view can't be combined with --discrete or --puzzles." << std::endl;
+		return 1;
+	}
+	if (config.sparse && (config.discrete || config.puzzles != "" || config.view != "")) {
+		std::cerr << "--sparse is only for locally played continuous boards (not --discrete, --puzzles, or --view)." << std::endl;
+		return 1;
+	}
+	if (config.puzzles != "" && config.record != "") {
+		//replays only store the seed of the starting board, not a puzzle's orientations:
+		std::cerr << "Recording puzzles is not supported." << std::endl;
+		return 1;
+	}
+
 	//------------  initialization ------------
 
+	startup_trace_begin("startup");
+
 	//Initialize SDL library:
+	startup_trace_begin("SDL_Init");
 	SDL_Init(SDL_INIT_VIDEO);
+	startup_trace_end();
 
 	//Ask for an OpenGL context version 3.3, core profile, enable debug:
 	SDL_GL_ResetAttributes();
@@ -47,6 +124,7 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
 	//create window:
+	startup_trace_begin("SDL_CreateWindow");
 	SDL_Window *window = SDL_CreateWindow(
 		config.title.c_str(),
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
@@ -54,6 +132,8 @@ int main(int argc, char **argv) {
 		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
 	);
 
+	startup_trace_end();
+
 	//prevent exceedingly tiny windows when resizing:
 	SDL_SetWindowMinimumSize(window, 100, 100);
 
@@ -63,7 +143,9 @@ int main(int argc, char **argv) {
 	}
 
 	//Create OpenGL context:
+	startup_trace_begin("SDL_GL_CreateContext");
 	SDL_GLContext context = SDL_GL_CreateContext(window);
+	startup_trace_end();
 
 	if (!context) {
 		SDL_DestroyWindow(window);
@@ -73,16 +155,20 @@ int main(int argc, char **argv) {
 
 	#ifdef _WIN32
 	//On windows, load OpenGL extensions:
+	startup_trace_begin("init_gl_shims");
 	init_gl_shims();
+	startup_trace_end();
 	#endif
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
+	startup_trace_begin("SDL_GL_SetSwapInterval");
 	if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
 		}
 	}
+	startup_trace_end();
 
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
@@ -90,7 +176,36 @@ int main(int argc, char **argv) {
 
 	//------------ create game object (loads assets) --------------
 
+	startup_trace_begin("Game::Game");
 	std::shared_ptr< Game > game = std::make_shared< Game >();
+	startup_trace_end();
+
+	if (config.puzzles != "") {
+		PuzzleSet set;
+		set.load(config.puzzles);
+		std::vector< uint8_t > orientations;
+		set.unpack(config.puzzle, &orientations);
+		game->sim.reset(set.board_size, set.infos[config.puzzle].seed, true);
+		game->sim.set_orientations(orientations);
+		game->sim.set_goal(std::vector< uint8_t >(orientations.size(), CubeRotations::Identity));
+		std::cout << "Puzzle " << config.puzzle << " of " << set.size() << " (" << int(set.infos[config.puzzle].moves) << " moves)." << std::endl;
+	} else if (config.discrete || config.sparse || config.board != glm::uvec2(0,0)) {
+		glm::uvec2 board_size = (config.board != glm::uvec2(0,0) ? config.board : game->sim.board_size);
+		game->sim.reset(board_size, game->sim.seed, config.discrete, config.sparse);
+	}
+	game->history.reset(game->sim);
+
+	if (config.view != "") {
+		game->view_from.reset(new SnapshotRing::Reader(config.view));
+	}
+
+	Replay recording;
+	if (config.record != "") {
+		recording.board_size = game->sim.board_size;
+		recording.seed = game->sim.seed;
+		recording.discrete = game->sim.discrete;
+		game->record_to = &recording;
+	}
 
 	//------------ main loop ------------
 
@@ -110,6 +225,11 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//the first frame is traced as part of startup, since GL drivers
+	//often defer work (e.g., actual buffer uploads) until first draw:
+	bool first_frame = true;
+	startup_trace_begin("first frame");
+
 	//This will loop until the game object is set to null:
 	while (game) {
 		//every pass through the game loop creates one frame of output
@@ -160,11 +280,26 @@ int main(int argc, char **argv) {
 
 		//Finally, wait until the recently-drawn frame is shown before doing it all again:
 		SDL_GL_SwapWindow(window);
+
+		if (first_frame) {
+			first_frame = false;
+			startup_trace_end(); //"first frame"
+			startup_trace_end(); //"startup"
+			if (config.startup_trace != "") {
+				startup_trace_print();
+				startup_trace_write(config.startup_trace);
+			}
+		}
 	}
 
 
 	//------------  teardown ------------
 
+	if (config.record != "") {
+		recording.save(config.record);
+		std::cout << "Wrote " << recording.inputs.size() << " ticks of input to '" << config.record << "'." << std::endl;
+	}
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
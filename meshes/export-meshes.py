@@ -3,7 +3,7 @@
 #based on 'export-sprites.py' and 'glsprite.py' from TCHOW Rainbow; code used is released into the public domain.
 
 #Note: Script meant to be executed from within blender, as per:
-#blender --background --python export-meshes.py -- <infile.blend> <outfile.blob>
+#blender --background --python export-meshes.py -- [--texcoords] [--palette] [--quantize] <infile.blend> <outfile.blob>
 
 import sys
 
@@ -12,8 +12,22 @@ for i in range(0,len(sys.argv)):
 	if sys.argv[i] == '--':
 		args = sys.argv[i+1:]
 
+#with --texcoords, also write texture coordinates and the name of each object's image texture
+# (the image itself is copied next to the output blob, where the game looks for it):
+do_texcoord = False
+#with --palette, write each vertex's color as an 8-bit index into a palette of the distinct
+# colors used (at most 256), instead of as four bytes per vertex (see MeshVertices.hpp):
+do_palette = False
+#with --quantize, write normals as four normalized signed bytes (instead of three floats):
+do_quantize = False
+while len(args) > 0 and args[0] in ['--texcoords', '--palette', '--quantize']:
+	if args[0] == '--texcoords': do_texcoord = True
+	if args[0] == '--palette': do_palette = True
+	if args[0] == '--quantize': do_quantize = True
+	args = args[1:]
+
 if len(args) != 2:
-	print("\n\nUsage:\nblender --background --python export-meshes.py -- <infile.blend> <outfile.blob>\nExports the meshes referenced by all objects to a binary blob, indexed by the names of the objects that reference them.\n")
+	print("\n\nUsage:\nblender --background --python export-meshes.py -- [--texcoords] [--palette] [--quantize] <infile.blend> <outfile.blob>\nExports the meshes referenced by all objects to a binary blob, indexed by the names of the objects that reference them.\n")
 	exit(1)
 
 infile = args[0]
@@ -21,12 +35,20 @@ outfile = args[1]
 
 import bpy, mathutils
 import struct
+import os, shutil
 
 import argparse
 
 bpy.ops.wm.open_mainfile(filepath=infile)
 
-do_texcoord = False
+#first image texture in any of the object's materials (or None):
+def image_texture(obj):
+	for mslot in obj.material_slots:
+		if mslot.material == None: continue
+		for tslot in mslot.material.texture_slots:
+			if tslot != None and tslot.texture != None and tslot.texture.type == 'IMAGE' and tslot.texture.image != None:
+				return tslot.texture.image
+	return None
 
 #names of objects whose meshes to write (not actually the names of the meshes):
 to_write = []
@@ -34,15 +56,46 @@ for obj in bpy.data.objects:
 	if obj.type == 'MESH':
 		to_write.append(obj.name)
 
-#data contains vertex and normal data from the meshes:
+#data contains vertex and normal data (and, without do_palette, color data) from the meshes:
 data = b''
 
+#the vertex schema describes each attribute in data (and color_indices) for the loader (see MeshVertices.hpp):
+GL_BYTE = 0x1400
+GL_UNSIGNED_BYTE = 0x1401
+GL_FLOAT = 0x1406
+schema = b''
+def attribute(name, chunk, type, count, normalized, integer, offset, stride):
+	global schema
+	schema += struct.pack('24s4sIIIIII', bytes(name, "utf8"), chunk, type, count, normalized, integer, offset, stride)
+vertex_size = 4*3 + (4 if do_quantize else 4*3) + (0 if do_palette else 4)
+attribute('Position', b'vtx0', GL_FLOAT, 3, 0, 0, 0, vertex_size)
+if do_quantize:
+	attribute('Normal', b'vtx0', GL_BYTE, 4, 1, 0, 4*3, vertex_size)
+else:
+	attribute('Normal', b'vtx0', GL_FLOAT, 3, 0, 0, 4*3, vertex_size)
+if do_palette:
+	attribute('ColorIndex', b'cix0', GL_UNSIGNED_BYTE, 1, 0, 1, 0, 1)
+else:
+	attribute('Color', b'vtx0', GL_UNSIGNED_BYTE, 4, 1, 0, vertex_size - 4, vertex_size)
+
+#palette contains the distinct vertex colors, and color_indices a palette index for every vertex in data (if do_palette):
+palette = b''
+palette_index = dict()
+color_indices = b''
+
 #strings contains the mesh names:
 strings = b''
 
 #index gives offsets into the data (and names) for each mesh:
 index = b''
 
+#texcoords contains a texture coordinate for every vertex in data (if do_texcoord):
+texcoords = b''
+
+#textures gives offsets into strings for the texture file name of each mesh (if do_texcoord):
+textures = b''
+copied = set()
+
 vertex_count = 0
 for name in to_write:
 	print("Writing '" + name + "'...")
@@ -79,6 +132,17 @@ for name in to_write:
 	index += struct.pack('I', vertex_count)
 	index += struct.pack('I', vertex_count + len(mesh.polygons) * 3)
 
+	#vertex colors come from the active vertex color layer if there is one, else from each face's material:
+	vertex_colors = None
+	if len(mesh.vertex_colors) > 0:
+		vertex_colors = mesh.vertex_colors.active.data
+	def face_color(poly):
+		if poly.material_index < len(obj.material_slots):
+			material = obj.material_slots[poly.material_index].material
+			if material != None:
+				return material.diffuse_color
+		return mathutils.Color((1.0, 1.0, 1.0))
+
 	uvs = None
 	if do_texcoord:
 		if len(obj.data.uv_layers) == 0:
@@ -86,6 +150,25 @@ for name in to_write:
 		else:
 			uvs = obj.data.uv_layers.active.data
 
+		#record the texture's file name (empty if none) and copy the image next to the blob:
+		texture_begin = len(strings)
+		image = image_texture(obj)
+		if image != None:
+			texture_name = bpy.path.basename(image.filepath)
+			if not texture_name.lower().endswith('.png'):
+				print("WARNING: texture '" + texture_name + "' of object '" + name + "' is not a PNG; the game will not be able to load it.")
+			if texture_name not in copied:
+				destination = os.path.join(os.path.dirname(outfile), texture_name)
+				if image.packed_file != None:
+					with open(destination, 'wb') as f:
+						f.write(image.packed_file.data)
+				else:
+					shutil.copyfile(bpy.path.abspath(image.filepath), destination)
+				copied.add(texture_name)
+			strings += bytes(texture_name, "utf8")
+		textures += struct.pack('I', texture_begin)
+		textures += struct.pack('I', len(strings))
+
 	#write the mesh:
 	for poly in mesh.polygons:
 		assert(len(poly.loop_indices) == 3)
@@ -95,39 +178,78 @@ for name in to_write:
 			vertex = mesh.vertices[loop.vertex_index]
 			for x in mesh.vertices[loop.vertex_index].co:
 				data += struct.pack('f', x)
-			for x in loop.normal:
-				data += struct.pack('f', x)
-			#TODO: set 'col' based on object's active vertex colors array.
-			# you should be able to use code much like the texcoord code below.
-			col = mathutils.Color((1.0, 1.0, 1.0))
-			data += struct.pack('BBBB', int(col.r * 255), int(col.g * 255), int(col.b * 255), 255)
+			if do_quantize:
+				n = loop.normal
+				data += struct.pack('bbbb', round(n.x * 127), round(n.y * 127), round(n.z * 127), 0)
+			else:
+				for x in loop.normal:
+					data += struct.pack('f', x)
+			if vertex_colors != None:
+				col = vertex_colors[poly.loop_indices[i]].color
+			else:
+				col = face_color(poly)
+			rgba = struct.pack('BBBB', int(col.r * 255), int(col.g * 255), int(col.b * 255), 255)
+			if do_palette:
+				if rgba not in palette_index:
+					if len(palette_index) == 256:
+						print("ERROR: more than 256 distinct vertex colors; export without --palette.")
+						exit(1)
+					palette_index[rgba] = len(palette_index)
+					palette += rgba
+				color_indices += struct.pack('B', palette_index[rgba])
+			else:
+				data += rgba
 
 			if do_texcoord:
 				if uvs != None:
 					uv = uvs[poly.loop_indices[i]].uv
-					data += struct.pack('ff', uv.x, uv.y)
+					texcoords += struct.pack('ff', uv.x, uv.y)
 				else:
-					data += struct.pack('ff', 0, 0)
+					texcoords += struct.pack('ff', 0, 0)
 	vertex_count += len(mesh.polygons) * 3
 
 #check that we wrote as much data as anticipated:
-assert(vertex_count * (4*3+4*3+4*1) == len(data))
-
-#write the data chunk and index chunk to an output blob:
+assert(vertex_count * vertex_size == len(data))
+if do_palette:
+	assert(vertex_count == len(color_indices))
+if do_texcoord:
+	assert(vertex_count * (4*2) == len(texcoords))
+
+#write the data chunk and index chunk to an output blob, in the aligned layout (see chunk_header.hpp):
+# a file header chunk (byte order mark, version, alignment), then chunks whose data starts at
+# multiples of 64 bytes, with padding chunks in between:
 blob = open(outfile, 'wb')
-#first chunk: the data
-blob.write(struct.pack('4s',b'dat0')) #type
-blob.write(struct.pack('I', len(data))) #length
-blob.write(data)
-#second chunk: the strings
-blob.write(struct.pack('4s',b'str0')) #type
-blob.write(struct.pack('I', len(strings))) #length
-blob.write(strings)
-#third chunk: the index
-blob.write(struct.pack('4s',b'idx0')) #type
-blob.write(struct.pack('I', len(index))) #length
-blob.write(index)
-
-print("Wrote " + str(blob.tell()) + " bytes [== " + str(len(data)+8) + " bytes of data + " + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index] to '" + outfile + "'")
+def write_chunk(magic, payload):
+	pad = (64 - (blob.tell() + 8) % 64) % 64
+	if pad != 0:
+		if pad < 8: pad += 64
+		blob.write(struct.pack('4s',b'pad0')) #type
+		blob.write(struct.pack('I', pad - 8)) #length
+		blob.write(bytes(pad - 8))
+	blob.write(struct.pack('4s',magic)) #type
+	blob.write(struct.pack('I', len(payload))) #length
+	blob.write(payload)
+blob.write(struct.pack('4s',b'chk1')) #type
+blob.write(struct.pack('I', 16)) #length
+blob.write(struct.pack('IIII', 0x01020304, 1, 64, 0))
+#first chunk: the vertex schema
+write_chunk(b'vsc0', schema)
+#then the data it describes:
+write_chunk(b'vtx0', data)
+if do_palette:
+	#(paletted colors: a palette index per vertex, then the palette)
+	write_chunk(b'cix0', color_indices)
+	write_chunk(b'pal0', palette)
+#next chunk: the strings
+write_chunk(b'str0', strings)
+#next chunk: the index
+write_chunk(b'idx0', index)
+if do_texcoord:
+	#next chunk: texture coordinates (parallel to the data chunk)
+	write_chunk(b'tex0', texcoords)
+	#last chunk: texture names (parallel to the index)
+	write_chunk(b'txr0', textures)
+
+print("Wrote " + str(blob.tell()) + " bytes [== " + str(len(schema)+8) + " bytes of schema + " + str(len(data)+8) + " bytes of data + " + ((str(len(palette)+8) + " bytes of palette (" + str(len(palette_index)) + " colors) + " + str(len(color_indices)+8) + " bytes of color indices + ") if do_palette else "") + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index" + ((" + " + str(len(texcoords)+8) + " bytes of texcoords + " + str(len(textures)+8) + " bytes of texture names") if do_texcoord else "") + " + header and padding] to '" + outfile + "'")
 
 blob.close()
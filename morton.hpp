@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+//Z-order (Morton order) helpers, for cells stored in small square tiles (see CellLayout.hpp and
+// PagedBoard.hpp, which both use 64x64).
+
+//spread the low eight bits of v to even bit positions (abcdefgh -> 0a0b0c0d0e0f0g0h):
+inline uint32_t morton_spread(uint32_t v) {
+	v = (v | (v << 4)) & 0x0f0f;
+	v = (v | (v << 2)) & 0x3333;
+	v = (v | (v << 1)) & 0x5555;
+	return v;
+}
+
+//index of (x,y) within a tile of up to 256x256 cells, interleaving the bits of x and y:
+inline uint32_t morton_index(uint32_t x, uint32_t y) {
+	return morton_spread(x) | (morton_spread(y) << 1);
+}
@@ -0,0 +1,196 @@
+//paged_board simulates and views a board larger than RAM, stored in a file (PagedBoard):
+// each frame, a camera window wanders over the board, the cross under a cursor in the window
+// is rolled, and the window is read out for drawing. Reports frame time percentiles and
+// chunk cache behavior.
+//
+//Usage:
+//  paged_board --file board.paged [--create WxH] [--seed S] [--cache-mb M] [--frames F]
+//              [--view WxH] [--no-prefetch] [--check] [--publish NAME]
+//With --create, the file is (re)created first (all cells at identity; the file is sparse, so
+// even 65536x65536 creates instantly, though it grows as chunks are touched).
+//With --check, every roll is mirrored on an in-memory board (so only for boards that fit)
+// and the two are compared at the end.
+//With --publish NAME, the window is published to shared memory each frame,
+// where 'main --view NAME' can watch it; frames are then paced to 60 per second, and it
+// runs until interrupted (Ctrl-C) rather than for --frames.
+
+#include "PagedBoard.hpp"
+#include "SnapshotRing.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <csignal>
+
+//set by SIGINT/SIGTERM; a publishing run continues until then:
+static volatile std::sig_atomic_t interrupted = 0;
+static void on_interrupt(int) {
+	interrupted = 1;
+}
+
+int main(int argc, char **argv) {
+	struct {
+		std::string file;
+		glm::uvec2 create = glm::uvec2(0,0);
+		uint32_t seed = 0xbead1234;
+		uint32_t cache_mb = 256;
+		uint32_t frames = 600;
+		glm::uvec2 view = glm::uvec2(64,48);
+		bool prefetch = true;
+		bool check = false;
+		std::string publish;
+	} config;
+
+	auto parse_size = [](char const *str, glm::uvec2 *size) {
+		unsigned w = 0, h = 0;
+		if (std::sscanf(str, "%ux%u", &w, &h) != 2 || w == 0 || h == 0) return false;
+		*size = glm::uvec2(w,h);
+		return true;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--file" && has_value) {
+			config.file = argv[++argi];
+		} else if (arg == "--create" && has_value) {
+			if (!parse_size(argv[++argi], &config.create)) {
+				std::cerr << "Expecting --create WxH." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--seed" && has_value) {
+			config.seed = uint32_t(std::strtoul(argv[++argi], nullptr, 0));
+		} else if (arg == "--cache-mb" && has_value) {
+			config.cache_mb = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--frames" && has_value) {
+			config.frames = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--view" && has_value) {
+			if (!parse_size(argv[++argi], &config.view)) {
+				std::cerr << "Expecting --view WxH." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--no-prefetch") {
+			config.prefetch = false;
+		} else if (arg == "--check") {
+			config.check = true;
+		} else if (arg == "--publish" && has_value) {
+			config.publish = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " --file board.paged [--create WxH] [--seed S] [--cache-mb M] [--frames F] [--view WxH] [--no-prefetch] [--check] [--publish NAME]" << std::endl;
+			return 1;
+		}
+	}
+	if (config.file == "") {
+		std::cerr << "Expecting --file." << std::endl;
+		return 1;
+	}
+
+	if (config.create != glm::uvec2(0,0)) {
+		PagedBoard::create(config.file, config.create, config.seed);
+	}
+	uint64_t chunk_bytes = (sizeof(PagedBoard::Chunk) + PagedBoard::PageBytes - 1) / PagedBoard::PageBytes * PagedBoard::PageBytes;
+	uint32_t max_resident = uint32_t(uint64_t(config.cache_mb) * 1024 * 1024 / chunk_bytes);
+	PagedBoard board(config.file, max_resident);
+	glm::uvec2 view = glm::min(config.view, board.board_size);
+	std::cout << "Board " << board.board_size.x << "x" << board.board_size.y << " ("
+		<< (uint64_t(board.chunks.x) * board.chunks.y * board.chunk_bytes >> 20) << " MB on disk), caching up to "
+		<< max_resident << " chunks (" << ((uint64_t(max_resident) * board.chunk_bytes) >> 20) << " MB)." << std::endl;
+
+	std::vector< glm::quat > mirror;
+	if (config.check) {
+		if (uint64_t(board.board_size.x) * board.board_size.y > (1ULL << 26)) {
+			std::cerr << "--check needs a board of at most 64M cells." << std::endl;
+			return 1;
+		}
+		mirror.assign(size_t(board.board_size.x) * board.board_size.y, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		for (uint32_t y = 0; y < board.board_size.y; ++y) {
+			for (uint32_t x = 0; x < board.board_size.x; ++x) {
+				mirror[size_t(y) * board.board_size.x + x] = board.rotation(x, y);
+			}
+		}
+	}
+
+	std::unique_ptr< SnapshotRing::Writer > publisher;
+	if (config.publish != "") {
+		publisher.reset(new SnapshotRing::Writer(config.publish, view.x * view.y));
+		std::signal(SIGINT, on_interrupt);
+		std::signal(SIGTERM, on_interrupt);
+		std::cout << "Publishing the window as '" << config.publish << "' at 60 frames/second; Ctrl-C to stop." << std::endl;
+	}
+
+	BoardSim window;
+	std::mt19937 mt(config.seed);
+	glm::ivec2 camera(mt() % (board.board_size.x - view.x + 1), mt() % (board.board_size.y - view.y + 1));
+	glm::ivec2 velocity(0,0);
+	std::vector< float > frame_seconds;
+	frame_seconds.reserve(config.frames);
+
+	auto paced_start = std::chrono::steady_clock::now();
+	for (uint32_t frame = 0; publisher ? !interrupted : frame < config.frames; ++frame) {
+		//camera drifts, changing direction now and then; cursor wanders within the view:
+		if (frame % 60 == 0) {
+			velocity = glm::ivec2(int32_t(mt() % 9) - 4, int32_t(mt() % 9) - 4);
+		}
+		camera = glm::clamp(camera + velocity, glm::ivec2(0), glm::ivec2(board.board_size - view));
+		glm::uvec2 origin(camera);
+		glm::uvec2 cursor = origin + glm::uvec2(mt() % view.x, mt() % view.y);
+		glm::quat dr = BoardSim::roll_rotation(BoardSim::controls_from_bits(1U << (mt() % 4)), 1.0f / 60.0f);
+
+		auto before = std::chrono::steady_clock::now();
+		if (config.prefetch) board.prefetch(cursor, origin, view);
+		board.roll_cross(cursor, dr);
+		board.read_window(origin, view, &window);
+		frame_seconds.emplace_back(std::chrono::duration< float >(std::chrono::steady_clock::now() - before).count());
+
+		if (config.check) {
+			BoardSim::roll_cross(mirror.data(), board.board_size, cursor, dr);
+		}
+		if (publisher) {
+			publisher->publish(window.board_size, cursor - origin, window.board_meshes.data(), window.board_rotations.data(), frame);
+			//(the camera moves a cell or so per frame, so unpaced it would be too fast to follow)
+			std::this_thread::sleep_until(paced_start + std::chrono::microseconds(uint64_t(frame + 1) * 1000000 / 60));
+		}
+	}
+	if (frame_seconds.empty()) {
+		std::cerr << "Interrupted before the first frame." << std::endl;
+		return 1;
+	}
+
+	std::vector< float > sorted = frame_seconds;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (float s : sorted) total += s;
+	auto percentile = [&](float p) { return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))]; };
+	std::cout << std::fixed << std::setprecision(3)
+		<< "Frame (roll + prefetch + read " << view.x << "x" << view.y << " window): avg " << total / sorted.size() * 1e3
+		<< " ms, p50 " << percentile(0.5f) * 1e3 << " ms, p99 " << percentile(0.99f) * 1e3 << " ms, max " << sorted.back() * 1e3 << " ms." << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << "Chunks: " << board.stats.hits << " hits, " << board.stats.misses << " misses, "
+		<< board.stats.evictions << " evictions, " << board.stats.prefetched << " prefetched; "
+		<< (board.resident_bytes() >> 20) << " MB resident." << std::endl;
+
+	if (config.check) {
+		uint64_t bad = 0;
+		for (uint32_t y = 0; y < board.board_size.y; ++y) {
+			for (uint32_t x = 0; x < board.board_size.x; ++x) {
+				glm::quat a = board.rotation(x, y);
+				glm::quat b = mirror[size_t(y) * board.board_size.x + x];
+				if (std::abs(std::abs(glm::dot(a, b)) - 1.0f) > 1e-4f) bad += 1;
+			}
+		}
+		std::cout << "Check: " << bad << " cells differ from the in-memory board." << std::endl;
+		if (bad) return 1;
+	}
+
+	return 0;
+}
@@ -4,18 +4,50 @@
 #include <vector>
 #include <stdexcept>
 #include <cassert>
+#include <string>
+#include <memory>
+#include <type_traits>
 
-template< typename T >
-void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *_to) {
-	assert(_to);
+#include "chunk_header.hpp"
+#include "Arena.hpp"
+#include "crc32c.hpp"
+
+//skip any file header and padding chunks (see chunk_header.hpp) at the current position in 'from',
+// checking the file header as it goes:
+inline void skip_chunk_padding(std::istream &from) {
+	while (true) {
+		std::streampos at = from.tellg();
+		ChunkHeader header;
+		if (!from.read(reinterpret_cast< char * >(&header), sizeof(header))) {
+			from.clear();
+			from.seekg(at);
+			return;
+		}
+		std::string magic(header.magic, 4);
+		uint32_t size = header.size & ~uint32_t(ChunkChecksumBit);
+		uint32_t trailer = (header.size & ChunkChecksumBit ? 4 : 0);
+		if (magic == "chk1") {
+			ChunkFileHeader file_header;
+			if (size != sizeof(file_header) || !from.read(reinterpret_cast< char * >(&file_header), sizeof(file_header))) {
+				throw std::runtime_error("Failed to read chunk file header.");
+			}
+			check_chunk_file_header(file_header);
+			from.seekg(trailer, std::ios::cur);
+		} else if (magic == "pad0") {
+			from.seekg(size + trailer, std::ios::cur);
+		} else {
+			from.seekg(at);
+			return;
+		}
+	}
+}
+
+//header of the next chunk in 'from' (after any padding), checked against 'magic' and 'element_size';
+// returns the size of its data and whether a checksum follows it:
+inline uint32_t read_chunk_header(std::istream &from, std::string const &magic, size_t element_size, bool *checksummed) {
 	assert(magic.length() == 4);
-	auto &to = *_to;
 
-	struct ChunkHeader {
-		char magic[4] = {'\0', '\0', '\0', '\0'};
-		uint32_t size = 0;
-	};
-	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+	skip_chunk_padding(from);
 
 	ChunkHeader header;
 	if (!from.read(reinterpret_cast< char * >(&header), sizeof(header))) {
@@ -25,12 +57,99 @@ void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *
 		throw std::runtime_error("Unexpected magic number in chunk");
 	}
 
-	if (header.size % sizeof(T) != 0) {
+	*checksummed = (header.size & ChunkChecksumBit) != 0;
+	uint32_t size = header.size & ~uint32_t(ChunkChecksumBit);
+
+	if (size % element_size != 0) {
 		throw std::runtime_error("Size of chunk not divisible by element size");
 	}
+	return size;
+}
+
+//data of the chunk whose header was just read (verifying its checksum, if it has one):
+inline void read_chunk_data(std::istream &from, std::string const &magic, void *to, uint32_t size, bool checksummed) {
+	if (!checksummed) {
+		if (!from.read(reinterpret_cast< char * >(to), size)) {
+			throw std::runtime_error("Failed to read chunk data.");
+		}
+	} else {
+		uint32_t crc = read_crc32c(from, to, size);
+		uint32_t expected = 0;
+		if (!from.read(reinterpret_cast< char * >(&expected), sizeof(expected))) {
+			throw std::runtime_error("Failed to read chunk checksum.");
+		}
+		if (crc != expected) {
+			throw std::runtime_error("Checksum mismatch in chunk '" + magic + "'.");
+		}
+	}
+}
+
+//read_chunk reads a vector of structures written by write_chunk, checking its magic number and size.
+//Chunks written with a checksum (ChunkChecksumBit set in the size) have it verified as they are read.
+template< typename T >
+void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *_to) {
+	assert(_to);
+	auto &to = *_to;
+
+	bool checksummed = false;
+	uint32_t size = read_chunk_header(from, magic, sizeof(T), &checksummed);
+	to.resize(size / sizeof(T));
+	read_chunk_data(from, magic, to.data(), size, checksummed);
+}
+
+//The vector version value-initializes (zeroes) every element before reading over it; these don't:
+
+//into caller-provided storage for up to 'capacity' elements (throws if the chunk is bigger);
+// returns the number of elements read:
+template< typename T >
+size_t read_chunk(std::istream &from, std::string const &magic, T *to, size_t capacity) {
+	static_assert(std::is_trivially_copyable< T >::value, "chunks hold plain data");
+	bool checksummed = false;
+	uint32_t size = read_chunk_header(from, magic, sizeof(T), &checksummed);
+	if (size / sizeof(T) > capacity) {
+		throw std::runtime_error("Chunk '" + magic + "' is larger than the space given for it.");
+	}
+	read_chunk_data(from, magic, to, size, checksummed);
+	return size / sizeof(T);
+}
+
+//into (cache-line aligned) space allocated from 'arena'; returns the elements, and their count in '*count':
+template< typename T >
+T *read_chunk(std::istream &from, std::string const &magic, Arena *arena, size_t *count) {
+	static_assert(std::is_trivially_copyable< T >::value, "chunks hold plain data");
+	assert(arena && count);
+	bool checksummed = false;
+	uint32_t size = read_chunk_header(from, magic, sizeof(T), &checksummed);
+	T *to = arena->alloc< T >(size / sizeof(T), Arena::Alignment);
+	read_chunk_data(from, magic, to, size, checksummed);
+	*count = size / sizeof(T);
+	return to;
+}
+
+//into a new (uninitialized) array; returns the elements, and their count in '*count':
+template< typename T >
+std::unique_ptr< T[] > read_chunk_uninitialized(std::istream &from, std::string const &magic, size_t *count) {
+	static_assert(std::is_trivially_copyable< T >::value && std::is_trivially_default_constructible< T >::value, "chunks hold plain data");
+	assert(count);
+	bool checksummed = false;
+	uint32_t size = read_chunk_header(from, magic, sizeof(T), &checksummed);
+	std::unique_ptr< T[] > to(new T[size / sizeof(T)]); //(default-initialized, i.e., left as-is)
+	read_chunk_data(from, magic, to.get(), size, checksummed);
+	*count = size / sizeof(T);
+	return to;
+}
 
-	to.resize(header.size / sizeof(T));
-	if (!from.read(reinterpret_cast< char * >(&to[0]), to.size() * sizeof(T))) {
-		throw std::runtime_error("Failed to read chunk data.");
+//magic number of the next chunk in 'from' ("" at end of file), without consuming it
+// (other than any file header and padding in front of it):
+inline std::string peek_chunk_magic(std::istream &from) {
+	skip_chunk_padding(from);
+	char magic[4];
+	std::streampos at = from.tellg();
+	if (!from.read(magic, 4)) {
+		from.clear();
+		from.seekg(at);
+		return "";
 	}
+	from.seekg(at);
+	return std::string(magic, 4);
 }
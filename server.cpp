@@ -0,0 +1,339 @@
+//server runs many independent boards headless (no window, no OpenGL),
+// sharded across worker threads, and reports simulation throughput and tick latency.
+//
+//Usage:
+//  server [--boards N] [--threads T] [--ticks K] [--size WxH] [--layout row|tiled] [--huge-pages off|thp|hugetlb]
+//         [--replay inputs.replay] [--publish NAME]
+//Without --replay, each board is driven by synthetic (random, key-holding) input.
+//With --replay, every board follows the input recorded by 'main --record inputs.replay'
+// (on a board of the recorded size), and the first board's hash is checked against the
+// recording every tick, to catch divergence from the reference implementation.
+//With --publish NAME, the first board is published to shared memory each tick,
+// where 'main --view NAME' can watch it; ticks are then paced to 60 per second, and the server
+// runs until interrupted (Ctrl-C) rather than for --ticks.
+//With --layout tiled, boards are stored in 64x64 Z-ordered tiles (see CellLayout) instead of row-major.
+//With --huge-pages, shard pools are backed by transparent or hugetlbfs huge pages where available
+// (see HugePages.hpp), which helps once boards are large enough for TLB misses to matter.
+
+#include "BoardSim.hpp"
+#include "CellLayout.hpp"
+#include "Arena.hpp"
+#include "SnapshotRing.hpp"
+#include "Replay.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+#include <csignal>
+
+//A shard is the set of boards owned by one worker thread.
+//All per-board state lives in the shard's arena, as structure-of-arrays:
+struct Shard {
+	uint32_t first_board = 0; //global index of first board in shard
+	uint32_t board_count = 0;
+	glm::uvec2 board_size = glm::uvec2(0,0);
+
+	std::unique_ptr< Arena > arena;
+	glm::quat *rotations = nullptr; //board_count * layout.storage_cells(), board-major
+	BoardSim::MeshId *meshes = nullptr; //board_count * layout.storage_cells()
+	BoardSim::TickInput *inputs = nullptr; //current input, per board
+	uint64_t *hashes = nullptr; //board hash (BoardSim::state_hash), per board
+	uint32_t *rng = nullptr; //synthetic input generator state, per board
+
+	std::vector< float > tick_seconds; //time taken to advance all boards in the shard, per tick
+	uint32_t first_mismatch = -1U; //first tick where board 0 didn't match the replay's hash
+};
+
+//set by SIGINT/SIGTERM; a publishing server runs until then:
+static volatile std::sig_atomic_t interrupted = 0;
+static void on_interrupt(int) {
+	interrupted = 1;
+}
+
+//xorshift32; cheap per-board random stream for synthetic input:
+static inline uint32_t next_random(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t boards = 4096;
+		uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+		uint32_t ticks = 600;
+		glm::uvec2 board_size = glm::uvec2(5,4);
+		CellLayout::Kind layout = CellLayout::RowMajor;
+		HugePages::Policy huge_pages = HugePages::Off;
+		std::string replay;
+		std::string publish;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--boards" && has_value) {
+			config.boards = std::atoi(argv[++argi]);
+		} else if (arg == "--threads" && has_value) {
+			config.threads = std::atoi(argv[++argi]);
+		} else if (arg == "--ticks" && has_value) {
+			config.ticks = std::atoi(argv[++argi]);
+		} else if (arg == "--size" && has_value) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++argi], "%ux%u", &w, &h) != 2) {
+				std::cerr << "Expecting --size WxH." << std::endl;
+				return 1;
+			}
+			config.board_size = glm::uvec2(w,h);
+		} else if (arg == "--layout" && has_value) {
+			std::string layout = argv[++argi];
+			if (layout == "row") config.layout = CellLayout::RowMajor;
+			else if (layout == "tiled") config.layout = CellLayout::Tiled;
+			else {
+				std::cerr << "Expecting --layout row or --layout tiled." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--huge-pages" && has_value) {
+			std::string policy = argv[++argi];
+			if (policy == "off") config.huge_pages = HugePages::Off;
+			else if (policy == "thp") config.huge_pages = HugePages::Transparent;
+			else if (policy == "hugetlb") config.huge_pages = HugePages::Explicit;
+			else {
+				std::cerr << "Expecting --huge-pages off, thp, or hugetlb." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--replay" && has_value) {
+			config.replay = argv[++argi];
+		} else if (arg == "--publish" && has_value) {
+			config.publish = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--boards N] [--threads T] [--ticks K] [--size WxH] [--layout row|tiled] [--huge-pages off|thp|hugetlb] [--replay inputs.replay] [--publish NAME]" << std::endl;
+			return 1;
+		}
+	}
+	if (config.boards == 0 || config.threads == 0 || config.ticks == 0 || config.board_size.x == 0 || config.board_size.y == 0) {
+		std::cerr << "Boards, threads, ticks, and board size must all be positive." << std::endl;
+		return 1;
+	}
+	config.threads = std::min(config.threads, config.boards);
+
+	Replay recorded;
+	std::vector< BoardSim::TickInput > &replay = recorded.inputs;
+	uint32_t seed = 0xbead1234;
+	if (config.replay != "") {
+		recorded.load(config.replay);
+		if (replay.empty()) {
+			std::cerr << "Replay '" << config.replay << "' contains no ticks." << std::endl;
+			return 1;
+		}
+		if (recorded.discrete) {
+			std::cerr << "Replay '" << config.replay << "' was recorded in discrete mode, which the server does not simulate." << std::endl;
+			return 1;
+		}
+		//replay on the recorded board, so hashes are comparable:
+		config.board_size = recorded.board_size;
+		seed = recorded.seed;
+	}
+
+	uint32_t const cells = config.board_size.x * config.board_size.y;
+	CellLayout const layout(config.layout, config.board_size);
+	uint32_t const storage = layout.storage_cells(); //array entries per board (>= cells, for padded tiles)
+
+	std::unique_ptr< SnapshotRing::Writer > publisher;
+	if (config.publish != "") {
+		publisher.reset(new SnapshotRing::Writer(config.publish, cells));
+		std::signal(SIGINT, on_interrupt);
+		std::signal(SIGTERM, on_interrupt);
+		std::cout << "Publishing board 0 as '" << config.publish << "' at 60 ticks/second; Ctrl-C to stop." << std::endl;
+	}
+
+	//split boards evenly among shards:
+	std::vector< Shard > shards(config.threads);
+	for (uint32_t s = 0, first = 0; s < shards.size(); ++s) {
+		shards[s].first_board = first;
+		shards[s].board_count = config.boards / config.threads + (s < config.boards % config.threads ? 1 : 0);
+		shards[s].board_size = config.board_size;
+		first += shards[s].board_count;
+	}
+
+	//workers initialize their own shard (so memory is first touched by the thread that uses it),
+	// then wait until every shard is ready before ticking:
+	std::atomic< uint32_t > ready(0);
+	std::atomic< bool > go(false);
+
+	auto run_shard = [&](Shard &shard) {
+		{ //allocate and initialize this shard's boards:
+			size_t bytes = shard.board_count * (storage * (sizeof(glm::quat) + sizeof(BoardSim::MeshId))
+				+ sizeof(BoardSim::TickInput) + sizeof(uint64_t) + sizeof(uint32_t)) + 5 * Arena::Alignment;
+			shard.arena.reset(new Arena(bytes, config.huge_pages));
+			shard.rotations = shard.arena->alloc< glm::quat >(shard.board_count * storage, Arena::Alignment);
+			shard.meshes = shard.arena->alloc< BoardSim::MeshId >(shard.board_count * storage, Arena::Alignment);
+			shard.inputs = shard.arena->alloc< BoardSim::TickInput >(shard.board_count, Arena::Alignment);
+			shard.hashes = shard.arena->alloc< uint64_t >(shard.board_count, Arena::Alignment);
+			shard.rng = shard.arena->alloc< uint32_t >(shard.board_count, Arena::Alignment);
+
+			for (uint32_t b = 0; b < shard.board_count; ++b) {
+				uint32_t board = shard.first_board + b;
+				//same mesh choice as BoardSim::reset:
+				std::mt19937 mt(seed + board);
+				shard.hashes[b] = 0;
+				glm::quat *rotations = shard.rotations + b * storage;
+				BoardSim::MeshId *meshes = shard.meshes + b * storage;
+				std::fill(rotations, rotations + storage, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+				std::fill(meshes, meshes + storage, BoardSim::Doll); //(padding, in tiled layout)
+				for (uint32_t cell = 0; cell < cells; ++cell) {
+					uint32_t i = layout.index(cell % config.board_size.x, cell / config.board_size.x);
+					meshes[i] = BoardSim::MeshId(mt() % BoardSim::MeshIdCount);
+					shard.hashes[b] ^= BoardSim::cell_hash(cell, meshes[i], BoardSim::quantize_rotation(rotations[i]));
+				}
+				shard.inputs[b] = BoardSim::TickInput();
+				shard.rng[b] = 0x9e3779b9u ^ (board * 0x85ebca6bu) ^ 1u;
+			}
+			shard.tick_seconds.reserve(config.ticks);
+		}
+
+		ready.fetch_add(1);
+		while (!go.load()) std::this_thread::yield();
+
+		std::vector< BoardSim::MeshId > publish_meshes;
+		std::vector< glm::quat > publish_rotations;
+
+		auto paced_start = std::chrono::steady_clock::now();
+		for (uint32_t tick = 0; publisher ? !interrupted : tick < config.ticks; ++tick) {
+			auto before = std::chrono::steady_clock::now();
+			for (uint32_t b = 0; b < shard.board_count; ++b) {
+				BoardSim::TickInput &input = shard.inputs[b];
+				if (!replay.empty()) {
+					input = replay[tick % replay.size()];
+				} else {
+					//synthetic input: hold a random set of roll keys for a while, occasionally move the cursor:
+					uint32_t r = next_random(&shard.rng[b]);
+					if ((r & 0x1f) == 0) input.controls = (r >> 5) & 0xf;
+					if ((r & 0x3e0) == 0) {
+						input.cursor_x = (r >> 10) % config.board_size.x;
+						input.cursor_y = (r >> 20) % config.board_size.y;
+					}
+					input.elapsed = 1.0f / 60.0f;
+				}
+				glm::quat dr = BoardSim::roll_rotation(BoardSim::controls_from_bits(input.controls), input.elapsed);
+				if (dr != glm::quat()) {
+					glm::uvec2 cursor = glm::min(glm::uvec2(input.cursor_x, input.cursor_y), config.board_size - glm::uvec2(1));
+					BoardSim::roll_cross(shard.rotations + b * storage, layout, cursor, dr,
+						shard.meshes + b * storage, &shard.hashes[b]);
+				}
+			}
+			//board 0 replays from the same start as the recording, so must match it:
+			if (shard.first_board == 0 && tick < recorded.hashes.size() && shard.first_mismatch == -1U) {
+				if (shard.hashes[0] != recorded.hashes[tick]) shard.first_mismatch = tick;
+			}
+			auto after = std::chrono::steady_clock::now();
+			shard.tick_seconds.emplace_back(std::chrono::duration< float >(after - before).count());
+
+			//the first board (in the first shard) is published for viewers:
+			if (publisher && shard.first_board == 0) {
+				BoardSim::TickInput const &input = shard.inputs[0];
+				glm::uvec2 cursor = glm::min(glm::uvec2(input.cursor_x, input.cursor_y), config.board_size - glm::uvec2(1));
+				if (layout.kind == CellLayout::RowMajor) {
+					publisher->publish(config.board_size, cursor, shard.meshes, shard.rotations, tick);
+				} else {
+					//snapshots are row-major; gather board 0 into that order first:
+					publish_meshes.resize(cells);
+					publish_rotations.resize(cells);
+					for (uint32_t cell = 0; cell < cells; ++cell) {
+						uint32_t i = layout.index(cell % config.board_size.x, cell / config.board_size.x);
+						publish_meshes[cell] = shard.meshes[i];
+						publish_rotations[cell] = shard.rotations[i];
+					}
+					publisher->publish(config.board_size, cursor, publish_meshes.data(), publish_rotations.data(), tick);
+				}
+			}
+
+			//a published board moves at real-time speed, so viewers can follow it:
+			if (publisher) {
+				std::this_thread::sleep_until(paced_start + std::chrono::microseconds(uint64_t(tick + 1) * 1000000 / 60));
+			}
+		}
+	};
+
+	std::vector< std::thread > workers;
+	workers.reserve(shards.size());
+	for (auto &shard : shards) {
+		workers.emplace_back(run_shard, std::ref(shard));
+	}
+	while (ready.load() < shards.size()) std::this_thread::yield();
+
+	auto start = std::chrono::steady_clock::now();
+	go.store(true);
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration< double >(end - start).count();
+
+	//gather per-shard tick latencies and report:
+	//(when publishing, shards stop on their own, so may not have run the same number of ticks)
+	std::vector< float > ticks;
+	size_t pool_bytes = 0;
+	double board_ticks = 0.0;
+	for (auto const &shard : shards) {
+		ticks.insert(ticks.end(), shard.tick_seconds.begin(), shard.tick_seconds.end());
+		pool_bytes += shard.arena->size();
+		board_ticks += double(shard.board_count) * shard.tick_seconds.size();
+	}
+	uint32_t const ticks_run = uint32_t(shards[0].tick_seconds.size());
+	if (ticks.empty()) {
+		std::cerr << "Interrupted before the first tick." << std::endl;
+		return 1;
+	}
+	std::sort(ticks.begin(), ticks.end());
+	auto percentile = [&ticks](double p) -> double {
+		size_t i = std::min(ticks.size() - 1, size_t(p * ticks.size()));
+		return ticks[i] * 1e6;
+	};
+
+	std::cout << config.boards << " boards of " << config.board_size.x << "x" << config.board_size.y
+		<< (layout.kind == CellLayout::Tiled ? " (tiled)" : "")
+		<< " on " << shards.size() << " threads, " << ticks_run << " ticks"
+		<< (replay.empty() ? " (synthetic input)" : " (replayed input)")
+		<< (publisher ? ", paced for publishing" : "") << "\n";
+	std::cout << "  pool memory: " << pool_bytes / 1024 << " KiB ("
+		<< double(pool_bytes) / config.boards << " bytes/board"
+		<< (shards[0].arena->pages ? std::string(", ") + HugePages::name(shards[0].arena->pages->source) + " pages" : std::string()) << ")\n";
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "  wall time: " << seconds * 1000.0 << " ms\n";
+	std::cout << "  throughput: " << board_ticks / seconds << " board-ticks/second\n";
+	std::cout << "  shard tick latency (us): p50 " << percentile(0.5)
+		<< "  p90 " << percentile(0.9)
+		<< "  p99 " << percentile(0.99)
+		<< "  p99.9 " << percentile(0.999)
+		<< "  max " << ticks.back() * 1e6 << std::endl;
+
+	if (!recorded.hashes.empty()) {
+		uint32_t checked = uint32_t(std::min< size_t >(ticks_run, recorded.hashes.size()));
+		if (shards[0].first_mismatch == -1U) {
+			std::cout << "  replay hash check: " << checked << " ticks match the recording" << std::endl;
+		} else {
+			std::cout << "  replay hash check: MISMATCH first at tick " << shards[0].first_mismatch
+				<< " (of " << checked << " checked)" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+//soft_render renders a (randomly rolled) board with SoftRenderer, without OpenGL:
+// reports time per frame and, with --scaling, how that changes from 1 to T threads
+// (checking that every thread count produces the same image).
+//
+//Usage:
+//  soft_render [--board WxH] [--image WxH] [--threads T] [--frames F] [--seed S] [--rolls R]
+//              [--scaling] [--meshes meshes.blob] [--out image.ppm]
+//(without --meshes, meshes.blob is loaded from next to the executable, as 'main' does)
+
+#include "SoftRenderer.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+
+int main(int argc, char **argv) {
+	struct {
+		glm::uvec2 board = glm::uvec2(16,16);
+		glm::uvec2 image = glm::uvec2(512,512);
+		uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+		uint32_t frames = 10;
+		uint32_t seed = 0xbead1234;
+		uint32_t rolls = 20;
+		bool scaling = false;
+		std::string meshes;
+		std::string out;
+	} config;
+
+	auto parse_size = [](char const *str, glm::uvec2 *size) {
+		unsigned w = 0, h = 0;
+		if (std::sscanf(str, "%ux%u", &w, &h) != 2 || w == 0 || h == 0) return false;
+		*size = glm::uvec2(w,h);
+		return true;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--board" && has_value) {
+			if (!parse_size(argv[++argi], &config.board)) {
+				std::cerr << "Expecting --board WxH." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--image" && has_value) {
+			if (!parse_size(argv[++argi], &config.image)) {
+				std::cerr << "Expecting --image WxH." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--threads" && has_value) {
+			config.threads = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--frames" && has_value) {
+			config.frames = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--seed" && has_value) {
+			config.seed = uint32_t(std::strtoul(argv[++argi], nullptr, 0));
+		} else if (arg == "--rolls" && has_value) {
+			config.rolls = std::max(0, std::atoi(argv[++argi]));
+		} else if (arg == "--scaling") {
+			config.scaling = true;
+		} else if (arg == "--meshes" && has_value) {
+			config.meshes = argv[++argi];
+		} else if (arg == "--out" && has_value) {
+			config.out = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--board WxH] [--image WxH] [--threads T] [--frames F] [--seed S] [--rolls R] [--scaling] [--meshes meshes.blob] [--out image.ppm]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::unique_ptr< SoftRenderer > renderer;
+	if (config.meshes.empty()) renderer.reset(new SoftRenderer());
+	else renderer.reset(new SoftRenderer(config.meshes));
+
+	//a board with some partial (continuous-mode) rolls, so cells are at assorted angles:
+	BoardSim sim;
+	sim.reset(config.board, config.seed);
+	std::mt19937 mt(config.seed);
+	for (uint32_t r = 0; r < config.rolls; ++r) {
+		BoardSim::RollAction action;
+		action.cursor_x = uint32_t(mt() % config.board.x);
+		action.cursor_y = uint32_t(mt() % config.board.y);
+		action.controls = uint8_t(1 << (mt() % 4));
+		action.angle = 0.1f + 0.5f * float(mt() % 16);
+		sim.apply_action(action);
+	}
+
+	std::vector< uint32_t > thread_counts;
+	if (config.scaling) {
+		for (uint32_t t = 1; t < config.threads; t *= 2) thread_counts.emplace_back(t);
+	}
+	thread_counts.emplace_back(config.threads);
+
+	std::vector< glm::u8vec4 > image, reference;
+	bool ok = true;
+	std::cout << config.board.x << "x" << config.board.y << " board at " << config.image.x << "x" << config.image.y << ":" << std::endl;
+	std::cout << "  threads | ms/frame | Mpixel/s | triangles" << std::endl;
+	for (uint32_t threads : thread_counts) {
+		renderer->threads = threads;
+		renderer->render(sim, config.image, &image); //warm-up (sizes buffers)
+		auto before = std::chrono::steady_clock::now();
+		for (uint32_t f = 0; f < config.frames; ++f) {
+			renderer->render(sim, config.image, &image);
+		}
+		double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count() / config.frames;
+
+		size_t triangles = 0;
+		for (auto const &worker : renderer->workers) triangles += worker.triangles.size();
+
+		std::cout << "  " << std::setw(7) << threads
+			<< " | " << std::fixed << std::setprecision(2) << std::setw(8) << seconds * 1e3
+			<< " | " << std::setw(8) << (double(config.image.x) * config.image.y / seconds * 1e-6)
+			<< " | " << std::setw(9) << triangles << std::endl;
+
+		if (reference.empty()) {
+			reference = image;
+		} else if (image != reference) {
+			std::cout << "  (image differs from the " << thread_counts[0] << "-thread image)" << std::endl;
+			ok = false;
+		}
+	}
+
+	if (!config.out.empty()) {
+		//binary PPM (alpha is dropped):
+		std::ofstream ppm(config.out, std::ios::binary);
+		ppm << "P6\n" << config.image.x << " " << config.image.y << "\n255\n";
+		for (glm::u8vec4 const &px : image) {
+			ppm.put(char(px.x)).put(char(px.y)).put(char(px.z));
+		}
+		if (!ppm) {
+			std::cerr << "Failed to write '" << config.out << "'." << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote '" << config.out << "'." << std::endl;
+	}
+
+	return (ok ? 0 : 1);
+}
@@ -0,0 +1,133 @@
+//solve finds shortest roll sequences for discrete-mode boards (see Solver.hpp)
+// and reports search speed.
+//
+//Usage:
+//  solve [--size WxH] [--scramble K] [--count N] [--seed S] [--threads T] [--max-depth D] [--scaling]
+//Generates N boards by applying K random quarter-turn rolls to a solved board, then solves each.
+//With --scaling, solves the same boards with 1, 2, 4, ... T threads and reports the speedup.
+
+#include "Solver.hpp"
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+int main(int argc, char **argv) {
+	struct {
+		glm::uvec2 board_size = glm::uvec2(5,4);
+		uint32_t scramble = 4;
+		uint32_t count = 10;
+		uint32_t seed = 1;
+		Solver::Options options;
+		bool scaling = false;
+	} config;
+	config.options.threads = std::max(1U, std::thread::hardware_concurrency());
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--size" && has_value) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++argi], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "Expecting --size WxH." << std::endl;
+				return 1;
+			}
+			config.board_size = glm::uvec2(w,h);
+		} else if (arg == "--scramble" && has_value) {
+			config.scramble = std::atoi(argv[++argi]);
+		} else if (arg == "--count" && has_value) {
+			config.count = std::atoi(argv[++argi]);
+		} else if (arg == "--seed" && has_value) {
+			config.seed = std::atoi(argv[++argi]);
+		} else if (arg == "--threads" && has_value) {
+			config.options.threads = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--max-depth" && has_value) {
+			config.options.max_depth = std::atoi(argv[++argi]);
+		} else if (arg == "--scaling") {
+			config.scaling = true;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--size WxH] [--scramble K] [--count N] [--seed S] [--threads T] [--max-depth D] [--scaling]" << std::endl;
+			return 1;
+		}
+	}
+
+	uint32_t cells = config.board_size.x * config.board_size.y;
+	std::vector< uint8_t > goal(cells, CubeRotations::Identity);
+
+	//scramble boards with random rolls:
+	std::vector< std::vector< uint8_t > > boards;
+	std::mt19937 mt(config.seed);
+	for (uint32_t b = 0; b < config.count; ++b) {
+		std::vector< uint8_t > board = goal;
+		for (uint32_t s = 0; s < config.scramble; ++s) {
+			Solver::Move move;
+			move.x = uint16_t(mt() % config.board_size.x);
+			move.y = uint16_t(mt() % config.board_size.y);
+			move.roll = CubeRotations::Roll(mt() % CubeRotations::RollCount);
+			Solver::apply(&board, config.board_size, move);
+		}
+		boards.emplace_back(board);
+	}
+
+	//solve all boards with the given thread count; returns nodes per second:
+	auto run = [&](uint32_t threads, bool verbose) -> double {
+		Solver::Options options = config.options;
+		options.threads = threads;
+		Solver solver(config.board_size, options);
+		uint64_t nodes = 0;
+		double seconds = 0.0;
+		for (uint32_t b = 0; b < boards.size(); ++b) {
+			Solver::Result result = solver.solve(boards[b], goal);
+			nodes += result.nodes;
+			seconds += result.seconds;
+
+			//double-check the solution:
+			std::vector< uint8_t > check = boards[b];
+			for (auto const &move : result.moves) {
+				Solver::apply(&check, config.board_size, move);
+			}
+			if (result.solved && check != goal) {
+				std::cerr << "ERROR: solution for board " << b << " does not reach the goal." << std::endl;
+				std::exit(1);
+			}
+
+			if (verbose) {
+				std::cout << "board " << b << ": ";
+				if (result.solved) {
+					std::cout << result.moves.size() << " moves";
+				} else {
+					std::cout << "no solution within " << solver.options.max_depth << " moves (at least " << result.lower_bound << " needed)";
+				}
+				std::cout << ", " << result.nodes << " nodes, " << std::fixed << std::setprecision(3) << result.seconds * 1000.0 << " ms\n";
+				std::cout.unsetf(std::ios::floatfield);
+			}
+		}
+		double rate = (seconds > 0.0 ? nodes / seconds : 0.0);
+		std::cout << threads << " thread(s): " << nodes << " nodes in " << std::fixed << std::setprecision(3) << seconds << " s = "
+			<< std::setprecision(0) << rate << " nodes/second" << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+		return rate;
+	};
+
+	if (config.scaling) {
+		double base = 0.0;
+		for (uint32_t threads = 1; ; threads = std::min(threads * 2, config.options.threads)) {
+			double rate = run(threads, false);
+			if (threads == 1) base = rate;
+			else if (base > 0.0) std::cout << "  speedup over 1 thread: " << std::setprecision(2) << rate / base << "x" << std::endl;
+			if (threads == config.options.threads) break;
+		}
+	} else {
+		run(config.options.threads, true);
+	}
+
+	return 0;
+}
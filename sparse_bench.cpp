@@ -0,0 +1,94 @@
+//sparse_bench compares dense and sparse (SparseRotations) storage of continuous-mode boards
+// where only a few crosses have been rolled: memory (and, for sparse storage, allocated chunks),
+// roll cost, the cost of a full scan (for_each_rotation, which visits every cell the way drawing
+// does), and of compute_hash (which, for sparse storage, visits only allocated chunks). Also
+// checks that both storage modes end up with the same board hash.
+//
+//Usage:
+//  sparse_bench [--rolls R] [--region S]
+//(rolls are at random cursors within an S x S region in the corner of the board)
+
+#include "BoardSim.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t rolls = 100;
+		uint32_t region = 16;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--rolls" && has_value) {
+			config.rolls = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--region" && has_value) {
+			config.region = std::max(1, std::atoi(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--rolls R] [--region S]" << std::endl;
+			return 1;
+		}
+	}
+
+	bool ok = true;
+	std::cout << "    board    mode |     rotation bytes | chunks | roll avg (us) | scan (ms) | hash (ms)" << std::endl;
+	for (glm::uvec2 size : {glm::uvec2(256,256), glm::uvec2(1024,1024), glm::uvec2(4096,4096)}) {
+		uint64_t hashes[2] = {0, 0};
+		for (bool sparse : {false, true}) {
+			BoardSim sim;
+			sim.reset(size, 0xbead1234, false, sparse);
+
+			std::mt19937 mt(1);
+			auto before = std::chrono::steady_clock::now();
+			for (uint32_t r = 0; r < config.rolls; ++r) {
+				BoardSim::RollAction action;
+				action.cursor_x = uint32_t(mt() % std::min(config.region, size.x));
+				action.cursor_y = uint32_t(mt() % std::min(config.region, size.y));
+				action.controls = uint8_t(1 << (mt() % 4));
+				action.angle = 0.1f;
+				sim.apply_action(action);
+			}
+			double roll_seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+
+			before = std::chrono::steady_clock::now();
+			float scan_sum = 0.0f;
+			sim.for_each_rotation([&](uint32_t, uint32_t, glm::quat const &r){ scan_sum += r.x; });
+			double scan_seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+			volatile float sink = scan_sum; //(so the scan isn't optimized out)
+			(void)sink;
+
+			before = std::chrono::steady_clock::now();
+			uint64_t hash = sim.compute_hash();
+			double hash_seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+
+			if (hash != sim.state_hash) {
+				std::cerr << "Incremental hash does not match full hash!" << std::endl;
+				ok = false;
+			}
+			hashes[sparse ? 1 : 0] = hash;
+
+			size_t bytes = (sparse ? sim.sparse_rotations.memory_bytes() : sim.board_rotations.capacity() * sizeof(glm::quat));
+			std::cout << std::setw(5) << size.x << "x" << std::setw(4) << size.y << " " << std::setw(7) << (sparse ? "sparse" : "dense")
+				<< " | " << std::setw(18) << bytes
+				<< " | " << std::setw(6) << (sparse ? std::to_string(sim.sparse_rotations.chunk_count()) : std::string("-"))
+				<< " | " << std::fixed << std::setprecision(2) << std::setw(13) << roll_seconds / config.rolls * 1e6
+				<< " | " << std::setw(9) << scan_seconds * 1e3
+				<< " | " << std::setw(9) << hash_seconds * 1e3 << std::endl;
+			std::cout.unsetf(std::ios::floatfield);
+		}
+		if (hashes[0] != hashes[1]) {
+			std::cerr << "Dense and sparse boards have different hashes!" << std::endl;
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include "startup_trace.hpp"
+
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <stdexcept>
+#include <cassert>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+//process CPU time (all threads) in seconds:
+static double cpu_seconds() {
+	#if defined(_WIN32)
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+	auto to_ticks = [](FILETIME const &ft) -> uint64_t {
+		return (uint64_t(ft.dwHighDateTime) << 32) | uint64_t(ft.dwLowDateTime);
+	};
+	//FILETIME is in 100ns units:
+	return double(to_ticks(kernel) + to_ticks(user)) * 1e-7;
+	#else
+	timespec ts;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0.0;
+	return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+	#endif
+}
+
+namespace {
+	struct Phase {
+		std::string name;
+		uint32_t depth = 0;
+		bool ended = false;
+		double wall_begin = 0.0, wall_end = 0.0; //seconds since program start
+		double cpu_begin = 0.0, cpu_end = 0.0; //seconds of process CPU time
+	};
+
+	struct Trace {
+		std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+		std::vector< Phase > phases; //in order of begin
+		std::vector< size_t > open; //stack of indices of phases that have not ended
+
+		double wall_seconds() const {
+			return std::chrono::duration< double >(std::chrono::steady_clock::now() - origin).count();
+		}
+	};
+
+	//constructed during static initialization, so 'origin' is close to program start:
+	Trace trace;
+}
+
+void startup_trace_begin(char const *name) {
+	Phase phase;
+	phase.name = name;
+	phase.depth = uint32_t(trace.open.size());
+	phase.cpu_begin = cpu_seconds();
+	phase.wall_begin = trace.wall_seconds();
+	trace.open.emplace_back(trace.phases.size());
+	trace.phases.emplace_back(phase);
+}
+
+void startup_trace_end() {
+	assert(!trace.open.empty() && "startup_trace_end without matching startup_trace_begin");
+	Phase &phase = trace.phases[trace.open.back()];
+	trace.open.pop_back();
+	phase.wall_end = trace.wall_seconds();
+	phase.cpu_end = cpu_seconds();
+	phase.ended = true;
+}
+
+void startup_trace_print() {
+	std::ostream &out = std::cout;
+	out << "---- startup trace (ms) ----\n";
+	out << std::setw(10) << "start" << std::setw(10) << "wall" << std::setw(10) << "cpu" << "  phase\n";
+	double total = 0.0;
+	for (auto const &phase : trace.phases) {
+		out << std::fixed << std::setprecision(2);
+		out << std::setw(10) << phase.wall_begin * 1000.0;
+		if (phase.ended) {
+			out << std::setw(10) << (phase.wall_end - phase.wall_begin) * 1000.0;
+			out << std::setw(10) << (phase.cpu_end - phase.cpu_begin) * 1000.0;
+			total = std::max(total, phase.wall_end);
+		} else {
+			out << std::setw(10) << "-" << std::setw(10) << "-";
+		}
+		out << "  " << std::string(2 * phase.depth, ' ') << phase.name << '\n';
+	}
+	out << "total (program start to end of last phase): " << total * 1000.0 << " ms" << std::endl;
+	out.unsetf(std::ios::floatfield);
+}
+
+void startup_trace_write(std::string const &filename) {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("Failed to open '" + filename + "' for writing startup trace.");
+	}
+
+	//JSON string escaping for phase names:
+	auto quote = [](std::string const &str) {
+		std::string ret = "\"";
+		for (char c : str) {
+			if (c == '"' || c == '\\') ret += '\\';
+			if (c >= 0 && c < ' ') continue;
+			ret += c;
+		}
+		return ret + "\"";
+	};
+
+	//trace-event format uses microsecond timestamps; phases are "complete" ('X') events:
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (auto const &phase : trace.phases) {
+		if (!phase.ended) continue;
+		if (!first) out << ",\n";
+		first = false;
+		out << "{\"name\":" << quote(phase.name)
+			<< ",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+			<< ",\"ts\":" << uint64_t(phase.wall_begin * 1e6)
+			<< ",\"dur\":" << uint64_t((phase.wall_end - phase.wall_begin) * 1e6)
+			<< ",\"args\":{\"cpu_us\":" << uint64_t((phase.cpu_end - phase.cpu_begin) * 1e6) << "}}";
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
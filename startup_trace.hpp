@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+//startup_trace records wall-clock and CPU time for each phase of startup,
+// so cold-start cost can be broken down and targeted.
+//Phases nest; mark them with begin/end pairs:
+//   startup_trace_begin("SDL_Init");
+//   SDL_Init(SDL_INIT_VIDEO);
+//   startup_trace_end();
+//...or with a scoped helper:
+//   { StartupPhase phase("read meshes.blob"); ... }
+//Times are measured relative to program start (static initialization).
+
+void startup_trace_begin(char const *name);
+void startup_trace_end();
+
+struct StartupPhase {
+	StartupPhase(char const *name) { startup_trace_begin(name); }
+	~StartupPhase() { startup_trace_end(); }
+	StartupPhase(StartupPhase const &) = delete;
+	StartupPhase &operator=(StartupPhase const &) = delete;
+};
+
+//print a table of all recorded phases to std::cout:
+void startup_trace_print();
+
+//write recorded phases as a Chrome trace-event JSON file
+// (load via chrome://tracing or https://ui.perfetto.dev):
+void startup_trace_write(std::string const &filename);
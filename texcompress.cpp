@@ -0,0 +1,237 @@
+//texcompress converts PNG textures to block-compressed '.bcn' files (see BCn.hpp), with
+// their whole mipmap chain, so TextureLoader can upload them as-is: no PNG decode or mipmap
+// filtering at load time, and 1/4 (BC3) or 1/8 (BC1) of the video memory of RGBA8.
+//
+//Usage:
+//  texcompress [--quality 0|1|2] [--format auto|bc1|bc3] [--threads T] in.png out.bcn
+//  texcompress [--quality 0|1|2] [--format auto|bc1|bc3] [--threads T] in.blob out.blob
+//The second form compresses every texture named by a meshes.blob (exported with --texcoords,
+// possibly atlased) and writes a copy of the blob naming the '.bcn' files instead; textures
+// are read from next to in.blob and written next to out.blob.
+//'auto' picks BC1 for textures that are fully opaque and BC3 otherwise; higher qualities
+// are slower to encode (see BCn::Quality). Size, speed, and error (PSNR) are reported.
+
+#include "BCn.hpp"
+#include "Mipmaps.hpp"
+#include "load_save_png.hpp"
+#include "MeshVertices.hpp"
+#include "read_chunk.hpp"
+#include "write_chunk.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+struct Config {
+	BCn::Quality quality = BCn::Normal;
+	std::string format = "auto";
+	uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+	std::string in;
+	std::string out;
+};
+
+//compress PNG 'in' to .bcn 'out', reporting on std::cout:
+static void compress(Config const &config, std::string const &in, std::string const &out) {
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > pixels;
+	load_png(in, &size, &pixels, LowerLeftOrigin);
+
+	BCn::Format format = (config.format == "bc1" ? BCn::BC1 : BCn::BC3);
+	if (config.format == "auto") {
+		bool opaque = std::all_of(pixels.begin(), pixels.end(), [](glm::u8vec4 const &px){ return px.w == 0xff; });
+		format = (opaque ? BCn::BC1 : BCn::BC3);
+	}
+
+	//mipmaps are filtered from the uncompressed image (filtering decoded blocks would compound error):
+	std::vector< std::vector< uint8_t > > levels;
+	double seconds = 0.0;
+	uint64_t texels = 0;
+	{
+		glm::uvec2 level_size = size;
+		std::vector< glm::u8vec4 > level = pixels, next;
+		while (true) {
+			levels.emplace_back(BCn::level_bytes(format, level_size));
+			auto before = std::chrono::steady_clock::now();
+			BCn::encode(format, config.quality, level_size, level.data(), levels.back().data(), config.threads);
+			seconds += std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+			texels += uint64_t(level_size.x) * level_size.y;
+			if (level_size == glm::uvec2(1)) break;
+			downsample(level_size, level, &next);
+			level.swap(next);
+			level_size = mipmap_size(level_size);
+		}
+	}
+
+	BCn::save(out, format, size, levels);
+
+	//error of the full-size level (alpha only counts for BC3, since BC1 drops it):
+	std::vector< glm::u8vec4 > decoded;
+	BCn::decode(format, size, levels[0].data(), &decoded);
+	uint32_t channels = (format == BCn::BC1 ? 3 : 4);
+	double sum = 0.0;
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		for (uint32_t c = 0; c < channels; ++c) {
+			double d = double(pixels[i][c]) - double(decoded[i][c]);
+			sum += d * d;
+		}
+	}
+	double mse = sum / (double(pixels.size()) * channels);
+	double psnr = (mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY);
+
+	size_t compressed = 0, uncompressed = 0;
+	{
+		glm::uvec2 level_size = size;
+		for (auto const &level : levels) {
+			compressed += level.size();
+			uncompressed += size_t(level_size.x) * level_size.y * sizeof(glm::u8vec4);
+			level_size = mipmap_size(level_size);
+		}
+	}
+
+	std::cout << in << " (" << size.x << "x" << size.y << ") -> " << out << ": "
+		<< (format == BCn::BC1 ? "BC1" : "BC3") << ", " << levels.size() << " levels, "
+		<< compressed << " bytes (" << std::fixed << std::setprecision(1) << double(uncompressed) / double(compressed) << ":1), "
+		<< std::setprecision(1) << (texels / 1e6) / seconds << " MPix/s, "
+		<< std::setprecision(2) << psnr << " dB PSNR" << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+//compress every texture named by blob 'in', and write a copy naming the results to 'out':
+static void compress_blob(Config const &config, std::string const &in, std::string const &out) {
+	struct IndexEntry {
+		uint32_t name_begin;
+		uint32_t name_end;
+		uint32_t vertex_begin;
+		uint32_t vertex_end;
+	};
+	static_assert(sizeof(IndexEntry) == 16, "IndexEntry should be packed.");
+	struct TextureEntry {
+		uint32_t name_begin;
+		uint32_t name_end;
+	};
+	static_assert(sizeof(TextureEntry) == 8, "TextureEntry should be packed.");
+	struct AtlasEntry {
+		uint32_t x, y, width, height;
+	};
+	static_assert(sizeof(AtlasEntry) == 16, "AtlasEntry should be packed.");
+
+	MeshVertices vertices; //(copied through as-is, palette and all)
+	std::vector< char > names;
+	std::vector< IndexEntry > index_entries;
+	std::vector< glm::vec2 > texcoords;
+	std::vector< TextureEntry > texture_entries;
+	std::vector< AtlasEntry > atlas_entries;
+	{
+		std::ifstream blob(in, std::ios::binary);
+		if (!blob) {
+			throw std::runtime_error("Failed to open '" + in + "'.");
+		}
+		vertices.read(blob);
+		read_chunk(blob, "str0", &names);
+		read_chunk(blob, "idx0", &index_entries);
+		if (blob.peek() == EOF) {
+			throw std::runtime_error("'" + in + "' has no textures (export it with --texcoords).");
+		}
+		read_chunk(blob, "tex0", &texcoords);
+		read_chunk(blob, "txr0", &texture_entries);
+		if (blob.peek() != EOF) {
+			read_chunk(blob, "atl0", &atlas_entries);
+		}
+	}
+
+	auto directory = [](std::string const &path) {
+		return path.substr(0, path.find_last_of("/\\") + 1);
+	};
+
+	//compress each distinct texture once, appending its new name to the strings:
+	std::map< std::string, TextureEntry > compressed;
+	for (TextureEntry &entry : texture_entries) {
+		if (entry.name_begin > entry.name_end || entry.name_end > names.size()) {
+			throw std::runtime_error("invalid name indices in texture index.");
+		}
+		std::string name(names.begin() + entry.name_begin, names.begin() + entry.name_end);
+		if (name.empty()) continue;
+		auto f = compressed.find(name);
+		if (f == compressed.end()) {
+			std::string bcn_name = name.substr(0, name.find_last_of('.')) + ".bcn";
+			compress(config, directory(in) + name, directory(out) + bcn_name);
+			TextureEntry bcn_entry;
+			bcn_entry.name_begin = uint32_t(names.size());
+			names.insert(names.end(), bcn_name.begin(), bcn_name.end());
+			bcn_entry.name_end = uint32_t(names.size());
+			f = compressed.emplace(name, bcn_entry).first;
+		}
+		entry = f->second;
+	}
+
+	std::ofstream blob(out, std::ios::binary);
+	write_chunk_file_header(blob);
+	vertices.write(blob, ChunkAligned);
+	write_chunk(blob, "str0", names, ChunkAligned);
+	write_chunk(blob, "idx0", index_entries, ChunkAligned);
+	write_chunk(blob, "tex0", texcoords, ChunkAligned);
+	write_chunk(blob, "txr0", texture_entries, ChunkAligned);
+	if (!atlas_entries.empty()) {
+		write_chunk(blob, "atl0", atlas_entries, ChunkAligned);
+	}
+	std::cout << "Compressed " << compressed.size() << " texture(s); wrote '" << out << "'." << std::endl;
+}
+
+int main(int argc, char **argv) {
+	Config config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--quality" && has_value) {
+			config.quality = BCn::Quality(glm::clamp(std::atoi(argv[++argi]), 0, 2));
+		} else if (arg == "--format" && has_value) {
+			config.format = argv[++argi];
+			if (config.format != "auto" && config.format != "bc1" && config.format != "bc3") {
+				config.out.clear();
+				break;
+			}
+		} else if (arg == "--threads" && has_value) {
+			config.threads = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg.size() > 0 && arg[0] != '-' && config.in.empty()) {
+			config.in = arg;
+		} else if (arg.size() > 0 && arg[0] != '-' && config.out.empty()) {
+			config.out = arg;
+		} else {
+			config.out.clear();
+			break;
+		}
+	}
+	if (config.out.empty()) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--quality 0|1|2] [--format auto|bc1|bc3] [--threads T] in.png out.bcn\n"
+			<< "\t" << argv[0] << " [--quality 0|1|2] [--format auto|bc1|bc3] [--threads T] in.blob out.blob" << std::endl;
+		return 1;
+	}
+
+	try {
+		auto ends_with = [](std::string const &s, std::string const &suffix) {
+			return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+		};
+		if (ends_with(config.in, ".blob")) {
+			compress_blob(config, config.in, config.out);
+		} else {
+			compress(config, config.in, config.out);
+		}
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+//thumbnails renders preview images of stored boards with SoftRenderer (no OpenGL needed):
+// every puzzle in PuzzleSet files (from 'generate') and the final board of Replay files
+// (from 'main --record'), one PNG per board, rendered in parallel. Reports images/second.
+//
+//Usage:
+//  thumbnails [--size WxH] [--threads T] [--out-dir DIR] [--limit N] [--meshes meshes.blob] FILE...
+//Images are named after their file: 'puzzles.set' gives DIR/puzzles-0.png, DIR/puzzles-1.png, ...
+// and 'session.replay' gives DIR/session.png.
+//meshes.blob is loaded once and shared by all threads; each thread reuses its own renderer,
+// board, and framebuffer from image to image.
+
+#include "SoftRenderer.hpp"
+#include "PuzzleSet.hpp"
+#include "Replay.hpp"
+#include "load_save_png.hpp"
+#include "data_path.hpp"
+#include "read_chunk.hpp"
+
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+
+//a file of stored boards:
+struct Source {
+	std::string stem; //file name without directory or extension
+	bool is_replay = false;
+	PuzzleSet puzzles;
+	Replay replay;
+
+	uint32_t boards() const { return (is_replay ? 1 : puzzles.size()); }
+
+	//set 'sim' to board 'index' (reusing 'orientations' as scratch space):
+	void load_board(uint32_t index, BoardSim *sim, std::vector< uint8_t > *orientations) const {
+		if (is_replay) {
+			sim->reset(replay.board_size, replay.seed, replay.discrete);
+			for (BoardSim::TickInput const &input : replay.inputs) {
+				sim->apply_input(input);
+				sim->update(input.elapsed);
+			}
+		} else {
+			sim->reset(puzzles.board_size, puzzles.infos[index].seed, true);
+			puzzles.unpack(index, orientations);
+			sim->set_orientations(*orientations);
+		}
+	}
+};
+
+int main(int argc, char **argv) {
+	struct {
+		glm::uvec2 size = glm::uvec2(256,256);
+		uint32_t threads = std::max(1U, std::thread::hardware_concurrency());
+		std::string out_dir = ".";
+		uint32_t limit = -1U;
+		std::string meshes;
+		std::vector< std::string > files;
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--size" && has_value) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++argi], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "Expecting --size WxH." << std::endl;
+				return 1;
+			}
+			config.size = glm::uvec2(w,h);
+		} else if (arg == "--threads" && has_value) {
+			config.threads = std::max(1, std::atoi(argv[++argi]));
+		} else if (arg == "--out-dir" && has_value) {
+			config.out_dir = argv[++argi];
+		} else if (arg == "--limit" && has_value) {
+			config.limit = std::max(0, std::atoi(argv[++argi]));
+		} else if (arg == "--meshes" && has_value) {
+			config.meshes = argv[++argi];
+		} else if (arg.size() > 0 && arg[0] != '-') {
+			config.files.emplace_back(arg);
+		} else {
+			config.files.clear();
+			break;
+		}
+	}
+	if (config.files.empty()) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--size WxH] [--threads T] [--out-dir DIR] [--limit N] [--meshes meshes.blob] FILE..." << std::endl;
+		return 1;
+	}
+
+	//load every source file up front (telling puzzle sets from replays by their first chunk's magic):
+	std::vector< Source > sources(config.files.size());
+	for (uint32_t i = 0; i < config.files.size(); ++i) {
+		std::string const &file = config.files[i];
+		Source &source = sources[i];
+
+		std::string base = file.substr(file.find_last_of("/\\") + 1);
+		source.stem = base.substr(0, base.find_last_of('.'));
+
+		std::ifstream in(file, std::ios::binary);
+		if (!in) {
+			std::cerr << "Failed to open '" << file << "'." << std::endl;
+			return 1;
+		}
+		//(past any file header and padding, so aligned files are recognized too):
+		std::string magic = peek_chunk_magic(in);
+		in.close();
+
+		if (magic == "rpl0") {
+			source.is_replay = true;
+			source.replay.load(file);
+		} else if (magic == "pzs0") {
+			source.puzzles.load(file);
+		} else {
+			std::cerr << "'" << file << "' is neither a puzzle set nor a replay." << std::endl;
+			return 1;
+		}
+	}
+
+	//one job per image:
+	struct Job {
+		uint32_t source;
+		uint32_t index;
+	};
+	std::vector< Job > jobs;
+	for (uint32_t s = 0; s < sources.size(); ++s) {
+		for (uint32_t i = 0; i < sources[s].boards() && jobs.size() < config.limit; ++i) {
+			jobs.emplace_back(Job{s, i});
+		}
+	}
+
+	auto meshes = std::make_shared< SoftRenderer::Meshes const >(config.meshes.empty() ? data_path("meshes.blob") : config.meshes);
+
+	//per-thread time spent rendering and encoding:
+	struct Timing {
+		double render = 0.0;
+		double encode = 0.0;
+	};
+	std::vector< Timing > timings(config.threads);
+
+	std::atomic< uint32_t > next_job(0);
+	std::atomic< bool > failed(false);
+	auto worker = [&](uint32_t t) {
+		SoftRenderer renderer(meshes); //(single-threaded; images are the unit of parallelism)
+		BoardSim sim;
+		std::vector< uint8_t > orientations;
+		std::vector< glm::u8vec4 > image;
+		Timing &timing = timings[t];
+
+		for (uint32_t j = next_job.fetch_add(1); j < jobs.size() && !failed; j = next_job.fetch_add(1)) {
+			Source const &source = sources[jobs[j].source];
+			std::string path = config.out_dir + "/" + source.stem
+				+ (source.is_replay ? "" : "-" + std::to_string(jobs[j].index)) + ".png";
+			try {
+				auto before = std::chrono::steady_clock::now();
+				source.load_board(jobs[j].index, &sim, &orientations);
+				renderer.render(sim, config.size, &image);
+				auto rendered = std::chrono::steady_clock::now();
+				save_png(path, config.size, image.data(), UpperLeftOrigin);
+				auto saved = std::chrono::steady_clock::now();
+				timing.render += std::chrono::duration< double >(rendered - before).count();
+				timing.encode += std::chrono::duration< double >(saved - rendered).count();
+			} catch (std::exception &e) {
+				std::cerr << "Failed on '" << path << "': " << e.what() << std::endl;
+				failed = true;
+			}
+		}
+	};
+
+	auto before = std::chrono::steady_clock::now();
+	std::vector< std::thread > threads;
+	for (uint32_t t = 0; t < config.threads; ++t) {
+		threads.emplace_back(worker, t);
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+	if (failed) return 1;
+
+	Timing total;
+	for (Timing const &timing : timings) {
+		total.render += timing.render;
+		total.encode += timing.encode;
+	}
+	std::cout << "Wrote " << jobs.size() << " " << config.size.x << "x" << config.size.y << " thumbnails to '" << config.out_dir << "' with "
+		<< config.threads << " thread(s) in " << std::fixed << std::setprecision(3) << seconds << " s = "
+		<< std::setprecision(1) << (seconds > 0.0 ? jobs.size() / seconds : 0.0) << " images/second." << std::endl;
+	if (!jobs.empty()) {
+		std::cout << "  per image (thread time): " << std::setprecision(2)
+			<< total.render / jobs.size() * 1e3 << " ms render, "
+			<< total.encode / jobs.size() * 1e3 << " ms PNG encode" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+//tween_bench measures the cost of advancing many simultaneous Tweens per frame
+// (e.g., every cell of the crosses being rolled on a very large board).
+//
+//Usage:
+//  tween_bench [--frames F]
+
+#include "Tweens.hpp"
+#include "CubeRotations.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t frames = 14; //a quarter turn at 60fps, minus the final frame
+	} config;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		bool has_value = (argi + 1 < argc);
+		if (arg == "--frames" && has_value) {
+			config.frames = std::max(1, std::atoi(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--frames F]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "  tweens | per frame (avg)     per tween" << std::endl;
+	for (uint32_t count : {100U, 1000U, 10000U, 100000U}) {
+		std::vector< glm::quat > rotations(count);
+		Tweens tweens;
+		std::mt19937 mt(1);
+		for (uint32_t i = 0; i < count; ++i) {
+			uint8_t o = uint8_t(mt() % CubeRotations::Count);
+			CubeRotations::Roll roll = CubeRotations::Roll(mt() % CubeRotations::RollCount);
+			tweens.add(i, CubeRotations::to_quat(o), CubeRotations::to_quat(CubeRotations::tables.roll[roll][o]), 0.25f);
+		}
+
+		double seconds = 0.0;
+		for (uint32_t f = 0; f < config.frames; ++f) {
+			auto before = std::chrono::steady_clock::now();
+			tweens.update(1.0f / 60.0f, rotations.data());
+			seconds += std::chrono::duration< double >(std::chrono::steady_clock::now() - before).count();
+		}
+		double per_frame = seconds / config.frames;
+		std::cout << std::setw(8) << count << " | " << std::fixed << std::setprecision(2)
+			<< std::setw(10) << per_frame * 1e6 << " us   " << std::setw(8) << per_frame / count * 1e9 << " ns" << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+	return 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+
+#include "chunk_header.hpp"
+#include "crc32c.hpp"
+
+enum ChunkFlags : uint32_t {
+	ChunkChecksum = 1, //follow the data with its CRC-32C (and set ChunkChecksumBit in the size)
+	ChunkAligned = 2, //pad so the data starts at a multiple of ChunkAlignment (for files begun with write_chunk_file_header)
+};
+
+//write_chunk is the counterpart to read_chunk: it writes a vector of structures
+// prefixed by a magic number and a byte count.
+template< typename T >
+void write_chunk(std::ostream &to, std::string const &magic, std::vector< T > const &from, uint32_t flags = 0) {
+	assert(magic.length() == 4);
+
+	if (flags & ChunkAligned) {
+		std::streamoff at = to.tellp();
+		if (at < 0) {
+			throw std::runtime_error("Can't align chunks in a stream without a position.");
+		}
+		uint32_t pad = chunk_padding(uint64_t(at));
+		if (pad != 0) {
+			ChunkHeader header;
+			header.magic[0] = 'p'; header.magic[1] = 'a'; header.magic[2] = 'd'; header.magic[3] = '0';
+			header.size = pad - uint32_t(sizeof(header));
+			static char const zeros[2 * ChunkAlignment] = { };
+			if (!to.write(reinterpret_cast< char const * >(&header), sizeof(header)) || !to.write(zeros, header.size)) {
+				throw std::runtime_error("Failed to write chunk padding.");
+			}
+		}
+	}
+
+	ChunkHeader header;
+	for (uint32_t i = 0; i < 4; ++i) {
+		header.magic[i] = magic[i];
+	}
+	//(the top bit of the size is the checksum flag):
+	if (from.size() * sizeof(T) > 0x7fffffffULL) {
+		throw std::runtime_error("Chunk data too large for chunk header.");
+	}
+	uint32_t size = uint32_t(from.size() * sizeof(T));
+	bool checksum = (flags & ChunkChecksum) != 0;
+	header.size = size | (checksum ? uint32_t(ChunkChecksumBit) : 0U);
+
+	if (!to.write(reinterpret_cast< char const * >(&header), sizeof(header))) {
+		throw std::runtime_error("Failed to write chunk header");
+	}
+	if (!to.write(reinterpret_cast< char const * >(from.data()), size)) {
+		throw std::runtime_error("Failed to write chunk data.");
+	}
+	if (checksum) {
+		uint32_t crc = crc32c(from.data(), size);
+		if (!to.write(reinterpret_cast< char const * >(&crc), sizeof(crc))) {
+			throw std::runtime_error("Failed to write chunk checksum.");
+		}
+	}
+}
+
+//start an aligned (revision 1) chunk file; write its chunks with ChunkAligned (see chunk_header.hpp):
+inline void write_chunk_file_header(std::ostream &to) {
+	write_chunk(to, "chk1", std::vector< ChunkFileHeader >(1));
+}